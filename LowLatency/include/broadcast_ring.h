@@ -0,0 +1,156 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <limits>
+
+#include "macros.h"
+#include "idle_strategy.h"
+#include "spsc_queue.h"
+
+namespace LL::Common {
+    constexpr size_t BROADCAST_RING_MAX_CONSUMERS = 8;
+
+    // Single-writer / multi-reader sequenced ring. Every registered consumer owns a cursor and reads the slots in
+    // place, the writer only reuses a slot once the slowest active consumer has moved past it. Sequence numbers
+    // start at 1 and are identical for every consumer, so they can double as the feed sequence number.
+    template<typename T>
+    class BroadcastRing final {
+    public:
+        using ConsumerId = size_t;
+
+        explicit BroadcastRing(size_t num_elems) : mask_(roundUpToPowerOfTwo(num_elems) - 1),
+                                                   store_(mask_ + 1, T()) {
+        }
+
+        auto capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+        // Opts the producer into waking consumers parked on the returned signal, must be called before the producer
+        // starts.
+        auto getWakeSignal() noexcept {
+            wake_enabled_ = true;
+            return &wake_signal_;
+        }
+
+        // Consumers register before they start reading and begin at the current write cursor.
+        auto addConsumer() noexcept -> ConsumerId {
+            const auto consumer_id = num_consumers_.load(std::memory_order_acquire);
+            ASSERT(consumer_id < consumers_.size(),
+                   "Too many BroadcastRing consumers, max:" + std::to_string(consumers_.size()));
+
+            auto &consumer = consumers_[consumer_id];
+            const auto start = write_index_.load(std::memory_order_acquire);
+            consumer.cursor_local_ = consumer.cached_write_index_ = start;
+            consumer.cursor_.store(start, std::memory_order_release);
+            consumer.active_.store(true, std::memory_order_release);
+            num_consumers_.store(consumer_id + 1, std::memory_order_release);
+            return consumer_id;
+        }
+
+        auto removeConsumer(ConsumerId consumer_id) noexcept {
+            consumers_.at(consumer_id).active_.store(false, std::memory_order_release);
+        }
+
+        // Writer side.
+        auto reserve(size_t n) noexcept -> size_t {
+            if (write_index_local_ + n - cached_gating_index_ > capacity()) {
+                cached_gating_index_ = minConsumerCursor();
+            }
+            return std::min(n, capacity() - (write_index_local_ - cached_gating_index_));
+        }
+
+        auto getWriteSlot(size_t i) noexcept {
+            return &store_[(write_index_local_ + i) & mask_];
+        }
+
+        auto publish(size_t n) noexcept {
+            write_index_local_ += n;
+            write_index_.store(write_index_local_, std::memory_order_release);
+            if (UNLIKELY(wake_enabled_))
+                wake_signal_.notify();
+        }
+
+        auto getNextToWriteTo() noexcept {
+            while (UNLIKELY(!reserve(1)));
+            return getWriteSlot(0);
+        }
+
+        auto updateWriteIndex() noexcept {
+            publish(1);
+        }
+
+        // Consumer side, each consumer must only be driven from one thread.
+        auto peek(ConsumerId consumer_id, size_t max_elems) noexcept -> size_t {
+            auto &consumer = consumers_[consumer_id];
+            if (consumer.cached_write_index_ - consumer.cursor_local_ < max_elems) {
+                consumer.cached_write_index_ = write_index_.load(std::memory_order_acquire);
+            }
+            return std::min(max_elems, consumer.cached_write_index_ - consumer.cursor_local_);
+        }
+
+        auto getReadSlot(ConsumerId consumer_id, size_t i) const noexcept -> const T * {
+            return &store_[(consumers_[consumer_id].cursor_local_ + i) & mask_];
+        }
+
+        auto getSequence(ConsumerId consumer_id, size_t i) const noexcept -> size_t {
+            return consumers_[consumer_id].cursor_local_ + i + 1;
+        }
+
+        auto consume(ConsumerId consumer_id, size_t n) noexcept {
+            auto &consumer = consumers_[consumer_id];
+            if (UNLIKELY(consumer.cursor_local_ + n > consumer.cached_write_index_))
+                FATAL("Consumed past the published elements in: " + std::to_string(pthread_self()));
+            consumer.cursor_local_ += n;
+            consumer.cursor_.store(consumer.cursor_local_, std::memory_order_release);
+        }
+
+        BroadcastRing() = delete;
+
+        BroadcastRing(const BroadcastRing &) = delete;
+
+        BroadcastRing(const BroadcastRing &&) = delete;
+
+        BroadcastRing &operator=(const BroadcastRing &) = delete;
+
+        BroadcastRing &operator=(const BroadcastRing &&) = delete;
+
+    private:
+        auto minConsumerCursor() const noexcept {
+            auto min_cursor = write_index_local_;
+            const auto num_consumers = num_consumers_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < num_consumers; ++i) {
+                const auto &consumer = consumers_[i];
+                if (consumer.active_.load(std::memory_order_acquire))
+                    min_cursor = std::min(min_cursor, consumer.cursor_.load(std::memory_order_acquire));
+            }
+            return min_cursor;
+        }
+
+        struct alignas(CACHE_LINE_SIZE) Consumer {
+            std::atomic<size_t> cursor_ = {0};
+            std::atomic<bool> active_ = {false};
+            size_t cursor_local_ = 0;
+            size_t cached_write_index_ = 0;
+        };
+
+        const size_t mask_;
+        std::vector<T> store_;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_index_ = {0};
+        size_t write_index_local_ = 0;
+        size_t cached_gating_index_ = 0;
+
+        alignas(CACHE_LINE_SIZE) WakeSignal wake_signal_;
+        bool wake_enabled_ = false;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> num_consumers_ = {0};
+        std::array<Consumer, BROADCAST_RING_MAX_CONSUMERS> consumers_;
+    };
+}
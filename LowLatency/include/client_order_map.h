@@ -0,0 +1,125 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "macros.h"
+#include "types.h"
+
+namespace LL::Common {
+    // Open-addressing (client_id, client_order_id) -> T* index with linear probing and backward-shift deletion.
+    // The table doubles above 1/2 load and halves below 1/8 load, so its footprint follows the number of live orders.
+    template<typename T>
+    class ClientOrderMap final {
+    public:
+        explicit ClientOrderMap(size_t min_capacity = 1024) : min_capacity_(roundUpToPowerOfTwo(std::max<size_t>(min_capacity, 16))) {
+            resize(min_capacity_);
+        }
+
+        auto find(ClientId client_id, OrderId client_order_id) const noexcept -> T * {
+            for (auto i = indexOf(client_id, client_order_id);; i = (i + 1) & mask_) {
+                const auto &entry = entries_[i];
+                if (!entry.value_)
+                    return nullptr;
+                if (entry.client_order_id_ == client_order_id && entry.client_id_ == client_id)
+                    return entry.value_;
+            }
+        }
+
+        auto insert(ClientId client_id, OrderId client_order_id, T *value) noexcept {
+            if (UNLIKELY((size_ + 1) * 2 > entries_.size()))
+                resize(entries_.size() * 2);
+
+            for (auto i = indexOf(client_id, client_order_id);; i = (i + 1) & mask_) {
+                auto &entry = entries_[i];
+                if (!entry.value_) {
+                    entry = {client_order_id, client_id, value};
+                    ++size_;
+                    return;
+                }
+                if (entry.client_order_id_ == client_order_id && entry.client_id_ == client_id) {
+                    entry.value_ = value;
+                    return;
+                }
+            }
+        }
+
+        auto erase(ClientId client_id, OrderId client_order_id) noexcept -> T * {
+            auto i = indexOf(client_id, client_order_id);
+            for (;; i = (i + 1) & mask_) {
+                const auto &entry = entries_[i];
+                if (!entry.value_)
+                    return nullptr;
+                if (entry.client_order_id_ == client_order_id && entry.client_id_ == client_id)
+                    break;
+            }
+
+            auto ret = entries_[i].value_;
+            for (auto j = (i + 1) & mask_; entries_[j].value_; j = (j + 1) & mask_) {
+                const auto home = indexOf(entries_[j].client_id_, entries_[j].client_order_id_);
+                if (((j - home) & mask_) >= ((j - i) & mask_)) {
+                    entries_[i] = entries_[j];
+                    i = j;
+                }
+            }
+            entries_[i] = Entry();
+            --size_;
+
+            if (UNLIKELY(entries_.size() > min_capacity_ && size_ * 8 < entries_.size()))
+                resize(entries_.size() / 2);
+            return ret;
+        }
+
+        auto clear() noexcept {
+            entries_.clear();
+            size_ = 0;
+            resize(min_capacity_);
+        }
+
+        auto size() const noexcept {
+            return size_;
+        }
+
+        auto capacity() const noexcept {
+            return entries_.size();
+        }
+
+    private:
+        struct Entry {
+            OrderId client_order_id_ = OrderId_INVALID;
+            ClientId client_id_ = ClientId_INVALID;
+            T *value_ = nullptr;
+        };
+
+        auto indexOf(ClientId client_id, OrderId client_order_id) const noexcept -> size_t {
+            const auto key = client_order_id ^ (static_cast<uint64_t>(client_id) << 40 | client_id);
+            return (key * 0x9E3779B97F4A7C15ull) >> shift_;
+        }
+
+        auto resize(size_t new_capacity) noexcept -> void {
+            auto old_entries = std::move(entries_);
+            entries_.assign(new_capacity, Entry());
+            mask_ = new_capacity - 1;
+            shift_ = 64 - __builtin_ctzll(new_capacity);
+
+            for (const auto &entry: old_entries) {
+                if (!entry.value_)
+                    continue;
+                auto i = indexOf(entry.client_id_, entry.client_order_id_);
+                while (entries_[i].value_)
+                    i = (i + 1) & mask_;
+                entries_[i] = entry;
+            }
+        }
+
+        const size_t min_capacity_;
+        std::vector<Entry> entries_;
+        size_t mask_ = 0;
+        int shift_ = 64;
+        size_t size_ = 0;
+    };
+}
@@ -7,7 +7,8 @@
 #include <sstream>
 
 #include "types.h"
-#include "lf_queue.h"
+#include "spsc_queue.h"
+#include "mpsc_queue.h"
 
 using namespace LL::Common;
 
@@ -70,5 +71,6 @@ namespace LL::Exchange {
     };
 #pragma  pack(pop)
 
-    using ClientRequestLFQueue = LFQueue<MEClientRequest>;
+    using ClientRequestLFQueue = SPSCQueue<MEClientRequest>;
+    using ClientRequestMPSCQueue = MPSCQueue<MEClientRequest>;
 }
@@ -6,7 +6,7 @@
 
 #include <sstream>
 #include "types.h"
-#include "lf_queue.h"
+#include "spsc_queue.h"
 
 using namespace LL::Common;
 
@@ -79,5 +79,5 @@ namespace LL::Exchange {
     };
 #pragma  pack(pop)
 
-    using ClientResponseLFQueue = LFQueue<MEClientResponse>;
+    using ClientResponseLFQueue = SPSCQueue<MEClientResponse>;
 }
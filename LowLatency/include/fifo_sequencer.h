@@ -4,20 +4,91 @@
 
 #pragma once
 
+#include <array>
+#include <algorithm>
+
 #include "thread_utils.h"
 #include "macros.h"
-
+#include "logging.h"
+#include "metrics.h"
 
 #include "client_request.h"
 
 namespace LL::Exchange {
     constexpr size_t ME_MAX_PENDING_REQUESTS = 1024;
 
+    // Collects the requests read from all client connections in one poll round and forwards them to the matching
+    // engine in order of their kernel receive stamps, so the order does not depend on which socket was read first.
     class FIFOSequencer {
     public:
+        FIFOSequencer(ClientRequestLFQueue *client_requests, Logger *logger)
+            : incoming_requests_(client_requests), logger_(logger),
+              kernel_to_sequence_latency_(
+                  MetricsRegistry::instance().histogram("Exchange/FIFOSequencer/kernel_to_sequence_ns")),
+              batch_size_(MetricsRegistry::instance().histogram("Exchange/FIFOSequencer/batch_size")) {
+        }
+
+        ~FIFOSequencer() = default;
+
+        auto addClientRequest(Nanos rx_time, const MEClientRequest &request) {
+            if (UNLIKELY(pending_size_ >= pending_client_requests_.size()))
+                FATAL("Too many pending requests");
+            pending_client_requests_[pending_size_++] = {rx_time, request};
+        }
+
+        auto sequenceAndPublish() {
+            if (UNLIKELY(!pending_size_))
+                return;
+
+            logger_->log("%:% %() % Processing % requests.\n", __FILE__, __LINE__, __FUNCTION__,
+                         getCurrentTimeStr(&time_str_), pending_size_);
+
+            std::stable_sort(pending_client_requests_.begin(), pending_client_requests_.begin() + pending_size_);
+
+            const auto now = getCurrentNanos();
+            for (size_t i = 0; i < pending_size_; ++i) {
+                const auto &client_request = pending_client_requests_[i];
+                logger_->log("%:% %() % Writing RX:% Req:% to FIFO.\n", __FILE__, __LINE__, __FUNCTION__,
+                             getCurrentTimeStr(&time_str_), client_request.recv_time_, client_request.request_);
+                if (LIKELY(now >= client_request.recv_time_))
+                    kernel_to_sequence_latency_->record(now - client_request.recv_time_);
+
+                auto next_write = incoming_requests_->getNextToWriteTo();
+                *next_write = client_request.request_;
+                incoming_requests_->updateWriteIndex();
+            }
+            batch_size_->record(pending_size_);
+            pending_size_ = 0;
+        }
+
+        FIFOSequencer() = delete;
+
+        FIFOSequencer(const FIFOSequencer &) = delete;
+
+        FIFOSequencer(const FIFOSequencer &&) = delete;
+
+        FIFOSequencer &operator=(const FIFOSequencer &) = delete;
+
+        FIFOSequencer &operator=(const FIFOSequencer &&) = delete;
+
     private:
+        struct RecvTimeClientRequest {
+            Nanos recv_time_ = 0;
+            MEClientRequest request_;
+
+            auto operator<(const RecvTimeClientRequest &rhs) const {
+                return recv_time_ < rhs.recv_time_;
+            }
+        };
+
         ClientRequestLFQueue *incoming_requests_ = nullptr;
         std::string time_str_;
         Logger *logger_ = nullptr;
+
+        std::array<RecvTimeClientRequest, ME_MAX_PENDING_REQUESTS> pending_client_requests_;
+        size_t pending_size_ = 0;
+
+        LatencyHistogram *kernel_to_sequence_latency_ = nullptr;
+        LatencyHistogram *batch_size_ = nullptr;
     };
 }
@@ -0,0 +1,173 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <climits>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "macros.h"
+#include "time_utils.h"
+
+namespace LL::Common {
+    enum class IdleStrategyType : int8_t {
+        BUSY_SPIN = 0,
+        PAUSE_SPIN = 1,
+        BACKOFF = 2,
+        PARK = 3,
+    };
+
+    inline auto idleStrategyTypeToString(IdleStrategyType type) -> std::string {
+        switch (type) {
+            case IdleStrategyType::BUSY_SPIN:
+                return "BUSY_SPIN";
+            case IdleStrategyType::PAUSE_SPIN:
+                return "PAUSE_SPIN";
+            case IdleStrategyType::BACKOFF:
+                return "BACKOFF";
+            case IdleStrategyType::PARK:
+                return "PARK";
+        }
+        return "UNKNOWN";
+    }
+
+    inline auto cpuPause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Futex word shared between a queue's producer and its parked consumers. Consumers arm() before their last poll
+    // and then wait(), producers notify() after every publish but only pay for the wake syscall when someone is armed.
+    class WakeSignal final {
+    public:
+        auto notify() noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (UNLIKELY(waiters_.load(std::memory_order_relaxed))) {
+                seq_.fetch_add(1, std::memory_order_release);
+                syscall(SYS_futex, &seq_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+            }
+        }
+
+        auto arm() noexcept {
+            const auto seq = seq_.load(std::memory_order_acquire);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            return seq;
+        }
+
+        auto wait(uint32_t armed_seq, Nanos timeout) noexcept {
+            const timespec ts{static_cast<time_t>(timeout / NANOS_TO_SECS), static_cast<long>(timeout % NANOS_TO_SECS)};
+            syscall(SYS_futex, &seq_, FUTEX_WAIT_PRIVATE, armed_seq, &ts, nullptr, 0);
+        }
+
+        auto disarm() noexcept {
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> seq_ = {0};
+        std::atomic<uint32_t> waiters_ = {0};
+    };
+
+    // What a run loop does when an iteration found no work. BUSY_SPIN never backs off, PAUSE_SPIN issues a pause per
+    // idle iteration, BACKOFF goes from spinning to pausing to yielding to short sleeps, PARK spins briefly and then
+    // sleeps on the queue's WakeSignal until the producer publishes.
+    class IdleStrategy final {
+    public:
+        static constexpr size_t SPIN_LIMIT = 100;
+        static constexpr size_t PAUSE_LIMIT = SPIN_LIMIT + 1000;
+        static constexpr size_t YIELD_LIMIT = PAUSE_LIMIT + 100;
+        static constexpr Nanos MIN_SLEEP = NANOS_TO_MICROS;
+        static constexpr Nanos MAX_SLEEP = NANOS_TO_MILLS;
+
+        explicit IdleStrategy(IdleStrategyType type = IdleStrategyType::BUSY_SPIN,
+                              WakeSignal *wake_signal = nullptr) noexcept
+            : type_(type == IdleStrategyType::PARK && !wake_signal ? IdleStrategyType::BACKOFF : type),
+              wake_signal_(wake_signal) {
+        }
+
+        auto type() const noexcept {
+            return type_;
+        }
+
+        auto idle(size_t work_count) noexcept {
+            if (LIKELY(work_count)) {
+                reset();
+                return;
+            }
+
+            switch (type_) {
+                case IdleStrategyType::BUSY_SPIN:
+                    break;
+                case IdleStrategyType::PAUSE_SPIN:
+                    cpuPause();
+                    break;
+                case IdleStrategyType::BACKOFF:
+                    backoff();
+                    break;
+                case IdleStrategyType::PARK:
+                    park();
+                    break;
+            }
+        }
+
+        auto reset() noexcept -> void {
+            idle_count_ = 0;
+            sleep_ = MIN_SLEEP;
+            if (armed_) {
+                wake_signal_->disarm();
+                armed_ = false;
+            }
+        }
+
+    private:
+        auto backoff() noexcept -> void {
+            ++idle_count_;
+            if (idle_count_ <= SPIN_LIMIT) {
+            } else if (idle_count_ <= PAUSE_LIMIT) {
+                cpuPause();
+            } else if (idle_count_ <= YIELD_LIMIT) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_));
+                sleep_ = std::min(sleep_ * 2, MAX_SLEEP);
+            }
+        }
+
+        // The consumer arms on one idle iteration and only waits on the next one, so the queue is always polled once
+        // more after the producer can see the waiter.
+        auto park() noexcept -> void {
+            ++idle_count_;
+            if (idle_count_ <= PAUSE_LIMIT) {
+                cpuPause();
+            } else if (!armed_) {
+                armed_seq_ = wake_signal_->arm();
+                armed_ = true;
+            } else {
+                wake_signal_->wait(armed_seq_, MAX_SLEEP);
+                wake_signal_->disarm();
+                armed_ = false;
+            }
+        }
+
+        IdleStrategyType type_;
+        WakeSignal *wake_signal_ = nullptr;
+
+        size_t idle_count_ = 0;
+        Nanos sleep_ = MIN_SLEEP;
+        bool armed_ = false;
+        uint32_t armed_seq_ = 0;
+    };
+}
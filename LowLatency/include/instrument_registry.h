@@ -0,0 +1,81 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+using namespace LL::Common;
+
+namespace LL::Exchange {
+    // Per instrument sizing of its MEOrderBook, the defaults are the old fixed per book sizes.
+    struct InstrumentCfg {
+        TickerId ticker_id_ = TickerId_INVALID;
+        std::string symbol_;
+        size_t max_orders_ = ME_MAX_ORDER_IDS;
+        size_t max_price_levels_ = ME_MAX_PRICE_LEVELS;
+        size_t price_ladder_levels_ = ME_PRICE_LADDER_LEVELS;
+
+        auto toString() const {
+            std::stringstream ss;
+            ss << "InstrumentCfg{"
+                    << "ticker:" << tickerIdToString(ticker_id_)
+                    << ", symbol:" << symbol_
+                    << ", max_orders:" << max_orders_
+                    << ", max_price_levels:" << max_price_levels_
+                    << ", price_ladder_levels:" << price_ladder_levels_
+                    << "}";
+            return ss.str();
+        }
+    };
+
+    // The tradable instruments, loaded once at startup and indexed by ticker id. Ticker ids need not be contiguous
+    // but the lookup table is sized by the largest one.
+    class InstrumentRegistry final {
+    public:
+        InstrumentRegistry() = default;
+
+        // One instrument per line: ticker_id symbol [max_orders [max_price_levels [price_ladder_levels]]], blank lines
+        // and lines starting with # are skipped.
+        static auto load(const std::string &path) -> InstrumentRegistry;
+
+        // Tickers 0 to num_instruments - 1 with default sizing.
+        static auto uniform(size_t num_instruments) -> InstrumentRegistry;
+
+        auto add(const InstrumentCfg &instrument) -> void;
+
+        auto find(TickerId ticker_id) const noexcept -> const InstrumentCfg * {
+            if (UNLIKELY(ticker_id >= instruments_.size() || instruments_[ticker_id].ticker_id_ == TickerId_INVALID))
+                return nullptr;
+            return &instruments_[ticker_id];
+        }
+
+        // One past the largest ticker id.
+        auto size() const noexcept {
+            return instruments_.size();
+        }
+
+        auto numInstruments() const noexcept {
+            return num_instruments_;
+        }
+
+        // Orders that can rest across all the instruments at once.
+        auto totalMaxOrders() const noexcept {
+            size_t total = 0;
+            for (const auto &instrument: instruments_) {
+                if (instrument.ticker_id_ != TickerId_INVALID)
+                    total += instrument.max_orders_;
+            }
+            return total;
+        }
+
+    private:
+        std::vector<InstrumentCfg> instruments_;
+        size_t num_instruments_ = 0;
+    };
+}
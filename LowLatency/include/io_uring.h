@@ -0,0 +1,296 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "macros.h"
+
+namespace LL::Common {
+    constexpr unsigned IoUringDefaultEntries = 4096;
+    constexpr uint16_t IoUringDefaultNumBuffers = 4096;
+    constexpr size_t IoUringDefaultBufferSize = 2048;
+    constexpr unsigned IoUringSQPollIdleMillis = 1000;
+    // user_data of buffer refills, above any user space pointer and the small tags the owners use.
+    constexpr uint64_t IoUringProvideBuffersTag = 1ull << 63;
+
+    // Minimal io_uring over the raw syscalls. The SQ array is mapped 1:1 onto the SQEs once at setup, so queuing an
+    // operation is a store into the next SQE and submit() publishes all queued SQEs with a single io_uring_enter, or
+    // with none at all when the SQPOLL thread is awake.
+    class IoUring final {
+    public:
+        explicit IoUring(unsigned entries = IoUringDefaultEntries, bool sqpoll = false, int sqpoll_cpu = -1) {
+            io_uring_params params{};
+            if (sqpoll) {
+                params.flags |= IORING_SETUP_SQPOLL;
+                params.sq_thread_idle = IoUringSQPollIdleMillis;
+                if (sqpoll_cpu >= 0) {
+                    params.flags |= IORING_SETUP_SQ_AFF;
+                    params.sq_thread_cpu = sqpoll_cpu;
+                }
+            }
+            ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            ASSERT(ring_fd_ >= 0, "io_uring_setup() failed. error:" + std::string(std::strerror(errno)));
+            sqpoll_ = sqpoll;
+
+            sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap)
+                sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+            sq_ring_ = mapRing(sq_ring_size_, IORING_OFF_SQ_RING);
+            cq_ring_ = single_mmap ? sq_ring_ : mapRing(cq_ring_size_, IORING_OFF_CQ_RING);
+            sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+            sqes_ = static_cast<io_uring_sqe *>(mapRing(sqes_size_, IORING_OFF_SQES));
+
+            auto sq = static_cast<char *>(sq_ring_);
+            sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+            sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+            sq_flags_ = reinterpret_cast<unsigned *>(sq + params.sq_off.flags);
+            sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+            sq_entries_ = params.sq_entries;
+            auto sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+            for (unsigned i = 0; i < sq_entries_; ++i)
+                sq_array[i] = i;
+            sqe_tail_ = *sq_tail_;
+
+            auto cq = static_cast<char *>(cq_ring_);
+            cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+            cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+            cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        }
+
+        ~IoUring() {
+            munmap(sqes_, sqes_size_);
+            if (cq_ring_ != sq_ring_)
+                munmap(cq_ring_, cq_ring_size_);
+            munmap(sq_ring_, sq_ring_size_);
+            close(ring_fd_);
+        }
+
+        auto fd() const noexcept {
+            return ring_fd_;
+        }
+
+        // Next free SQE, zeroed, or nullptr if the submission queue is full and needs a submit() first.
+        auto getSqe() noexcept -> io_uring_sqe * {
+            const auto head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+            if (UNLIKELY(sqe_tail_ - head >= sq_entries_))
+                return nullptr;
+            auto sqe = &sqes_[sqe_tail_ & sq_mask_];
+            ++sqe_tail_;
+            memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        auto getSqeOrSubmit() noexcept -> io_uring_sqe * {
+            auto sqe = getSqe();
+            while (UNLIKELY(!sqe)) {
+                submit();
+                sqe = getSqe();
+            }
+            return sqe;
+        }
+
+        auto prepRecvMultishot(int fd, uint16_t buffer_group, uint64_t user_data) noexcept {
+            auto sqe = getSqeOrSubmit();
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = fd;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = buffer_group;
+            sqe->user_data = user_data;
+        }
+
+        auto prepAcceptMultishot(int fd, uint64_t user_data) noexcept {
+            auto sqe = getSqeOrSubmit();
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = fd;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->user_data = user_data;
+        }
+
+        auto prepSend(int fd, const void *data, size_t len, uint64_t user_data) noexcept {
+            auto sqe = getSqeOrSubmit();
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(data);
+            sqe->len = static_cast<uint32_t>(len);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = user_data;
+        }
+
+        // Publishes every SQE queued since the last call. Only enters the kernel when there is something to submit,
+        // or to wait for, and with SQPOLL only when the poller thread has gone idle.
+        auto submit(unsigned wait_nr = 0) noexcept -> int {
+            const auto to_submit = sqe_tail_ - submitted_tail_;
+            std::atomic_ref<unsigned>(*sq_tail_).store(sqe_tail_, std::memory_order_release);
+            submitted_tail_ = sqe_tail_;
+
+            unsigned flags = wait_nr ? IORING_ENTER_GETEVENTS : 0;
+            if (sqpoll_) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (std::atomic_ref<unsigned>(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_NEED_WAKEUP)
+                    flags |= IORING_ENTER_SQ_WAKEUP;
+                else if (!wait_nr)
+                    return static_cast<int>(to_submit);
+            } else if (!to_submit && !wait_nr) {
+                return 0;
+            }
+
+            return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags, nullptr, 0));
+        }
+
+        // Hands every available completion to func and releases them back to the kernel in one store.
+        template<typename F>
+        auto forEachCqe(F &&func) noexcept {
+            auto head = *cq_head_;
+            const auto tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+            const auto num_cqes = tail - head;
+            for (; head != tail; ++head)
+                func(cqes_[head & cq_mask_]);
+            std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+            return num_cqes;
+        }
+
+        IoUring(const IoUring &) = delete;
+
+        IoUring(const IoUring &&) = delete;
+
+        IoUring &operator=(const IoUring &) = delete;
+
+        IoUring &operator=(const IoUring &&) = delete;
+
+    private:
+        auto mapRing(size_t size, off_t offset) const -> void * {
+            auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+            ASSERT(ptr != MAP_FAILED, "io_uring mmap() failed. error:" + std::string(std::strerror(errno)));
+            return ptr;
+        }
+
+        int ring_fd_ = -1;
+        bool sqpoll_ = false;
+
+        void *sq_ring_ = nullptr;
+        void *cq_ring_ = nullptr;
+        size_t sq_ring_size_ = 0;
+        size_t cq_ring_size_ = 0;
+        io_uring_sqe *sqes_ = nullptr;
+        size_t sqes_size_ = 0;
+
+        unsigned *sq_head_ = nullptr;
+        unsigned *sq_tail_ = nullptr;
+        unsigned *sq_flags_ = nullptr;
+        unsigned sq_mask_ = 0;
+        unsigned sq_entries_ = 0;
+        unsigned sqe_tail_ = 0;
+        unsigned submitted_tail_ = 0;
+
+        unsigned *cq_head_ = nullptr;
+        unsigned *cq_tail_ = nullptr;
+        unsigned cq_mask_ = 0;
+        io_uring_cqe *cqes_ = nullptr;
+    };
+
+    // Pool of receive buffers handed to the kernel for one buffer group. Multishot receives pick a buffer per
+    // completion and report its id in the CQE flags, the consumer hands it back with recycle() once the bytes are used,
+    // which rides along with the next submit(). Uses IORING_OP_PROVIDE_BUFFERS rather than a registered buffer ring,
+    // receives from a registered ring came back with ENOBUFS on the kernel we test on. Refill completions are skipped
+    // on success, owners pass every CQE through onCompletion() first so a failed refill is queued again instead of
+    // the buffers being lost to the pool.
+    class IoUringBufferPool final {
+    public:
+        IoUringBufferPool(IoUring &ring, uint16_t buffer_group,
+                          uint16_t num_buffers = IoUringDefaultNumBuffers,
+                          size_t buffer_size = IoUringDefaultBufferSize)
+            : ring_(ring), buffer_group_(buffer_group), num_buffers_(num_buffers), buffer_size_(buffer_size) {
+            buffers_size_ = num_buffers_ * buffer_size_;
+            auto buffers = mmap(nullptr, buffers_size_, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            ASSERT(buffers != MAP_FAILED, "IoUringBufferPool mmap() failed. error:" + std::string(std::strerror(errno)));
+            buffers_ = static_cast<char *>(buffers);
+
+            provide(0, num_buffers_);
+        }
+
+        ~IoUringBufferPool() {
+            munmap(buffers_, buffers_size_);
+        }
+
+        auto bufferGroup() const noexcept {
+            return buffer_group_;
+        }
+
+        static auto bufferId(const io_uring_cqe &cqe) noexcept {
+            return static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+
+        auto buffer(uint16_t bid) const noexcept {
+            return buffers_ + bid * buffer_size_;
+        }
+
+        auto recycle(uint16_t bid) noexcept {
+            provide(bid, 1);
+        }
+
+        // Returns true if cqe is a failed refill of this pool, which is retried with the next submit().
+        auto onCompletion(const io_uring_cqe &cqe) noexcept -> bool {
+            if (!(cqe.user_data & IoUringProvideBuffersTag) ||
+                static_cast<uint16_t>(cqe.user_data >> 32) != buffer_group_)
+                return false;
+            ++provide_failures_;
+            provide(static_cast<uint16_t>(cqe.user_data), static_cast<uint16_t>(cqe.user_data >> 16));
+            return true;
+        }
+
+        auto provideFailures() const noexcept {
+            return provide_failures_;
+        }
+
+        IoUringBufferPool() = delete;
+
+        IoUringBufferPool(const IoUringBufferPool &) = delete;
+
+        IoUringBufferPool(const IoUringBufferPool &&) = delete;
+
+        IoUringBufferPool &operator=(const IoUringBufferPool &) = delete;
+
+        IoUringBufferPool &operator=(const IoUringBufferPool &&) = delete;
+
+    private:
+        // No completion on success, a failure completes with the group, count and first id in user_data.
+        auto provide(uint16_t bid, uint16_t num_buffers) noexcept -> void {
+            auto sqe = ring_.getSqeOrSubmit();
+            sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+            sqe->fd = num_buffers;
+            sqe->addr = reinterpret_cast<uint64_t>(buffer(bid));
+            sqe->len = static_cast<uint32_t>(buffer_size_);
+            sqe->off = bid;
+            sqe->buf_group = buffer_group_;
+            sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+            sqe->user_data = IoUringProvideBuffersTag | static_cast<uint64_t>(buffer_group_) << 32 |
+                             static_cast<uint64_t>(num_buffers) << 16 | bid;
+        }
+
+        IoUring &ring_;
+        const uint16_t buffer_group_;
+        const uint16_t num_buffers_;
+        const size_t buffer_size_;
+
+        char *buffers_ = nullptr;
+        size_t buffers_size_ = 0;
+        size_t provide_failures_ = 0;
+    };
+}
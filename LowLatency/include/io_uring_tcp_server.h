@@ -0,0 +1,97 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include "tcp_socket.h"
+#include "io_uring.h"
+
+namespace LL::Common {
+    // io_uring flavour of TCPServer with the same callback contract. Accepts and receives are multishot operations
+    // fed from a provided buffer pool, so a burst of messages on any number of connections costs one
+    // io_uring_enter per poll()/sendAndRecv() round, or none under SQPOLL. Received bytes land in the socket's
+    // inbound_data_ like with TCPServer, sends go out asynchronously from outbound_data_.
+    struct IoUringTCPServer {
+        explicit IoUringTCPServer(Logger &logger, size_t socket_buffer_size = TCPBufferSize,
+                                  unsigned ring_entries = IoUringDefaultEntries, bool sqpoll = false,
+                                  int sqpoll_cpu = -1, const std::string &metrics_prefix = "Common/IoUringTCPServer")
+            : listener_socket_(logger, 0, metrics_prefix + "/TCPSocket"), socket_buffer_size_(socket_buffer_size),
+              metrics_prefix_(metrics_prefix), ring_(ring_entries, sqpoll, sqpoll_cpu), buffers_(ring_, 0),
+              logger_(logger),
+              send_and_recv_latency_(MetricsRegistry::instance().histogram(metrics_prefix + "/sendAndRecv_ns")) {
+        }
+
+        ~IoUringTCPServer();
+
+        auto listen(const std::string &iface, int port) -> void;
+
+        auto poll() noexcept -> void;
+
+        auto sendAndRecv() noexcept -> void;
+
+        auto getConnection(int fd) const noexcept -> TCPSocket * {
+            return (fd >= 0 && static_cast<size_t>(fd) < connections_.size()) ? connections_[fd] : nullptr;
+        }
+
+        auto numConnections() const noexcept {
+            return num_connections_;
+        }
+
+        IoUringTCPServer() = delete;
+
+        IoUringTCPServer(const IoUringTCPServer &) = delete;
+
+        IoUringTCPServer(const IoUringTCPServer &&) = delete;
+
+        IoUringTCPServer &operator=(const IoUringTCPServer &) = delete;
+
+        IoUringTCPServer &operator=(const IoUringTCPServer &&) = delete;
+
+    private:
+        enum class Op : uint64_t {
+            ACCEPT = 1,
+            RECV = 2,
+            SEND = 3,
+        };
+
+        static constexpr uint64_t OpMask = 0x7;
+
+        static auto toUserData(TCPSocket *socket, Op op) noexcept {
+            return reinterpret_cast<uint64_t>(socket) | static_cast<uint64_t>(op);
+        }
+
+        auto onAccept(const io_uring_cqe &cqe) noexcept -> void;
+
+        auto onRecv(TCPSocket *socket, const io_uring_cqe &cqe) noexcept -> void;
+
+        auto onSend(TCPSocket *socket, const io_uring_cqe &cqe) noexcept -> void;
+
+        auto closeConnection(TCPSocket *socket) noexcept -> void;
+
+    public:
+        TCPSocket listener_socket_;
+        size_t socket_buffer_size_ = TCPBufferSize;
+        const std::string metrics_prefix_;
+
+        IoUring ring_;
+        IoUringBufferPool buffers_;
+
+        // Live connections and their in-flight operation count indexed by fd. A closed socket is only freed once the
+        // kernel has completed every operation that still references it.
+        std::vector<TCPSocket *> connections_;
+        std::vector<uint32_t> pending_ops_;
+        size_t num_connections_ = 0;
+        std::vector<TCPSocket *> ready_sockets_;
+
+        std::function<void(TCPSocket *s,
+                           Nanos rx_time)> recv_callback_{nullptr};
+        std::function<void()> recv_finished_callback_{nullptr};
+        std::function<void(TCPSocket *s)> disconnect_callback_{nullptr};
+
+        std::string time_str_;
+        Logger &logger_;
+
+        LatencyHistogram *send_and_recv_latency_ = nullptr;
+    };
+}
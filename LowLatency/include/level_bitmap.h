@@ -0,0 +1,135 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "macros.h"
+
+namespace LL::Common {
+    // Three level occupancy bitmap over up to 64^3 slots. Every bit of a summary word says whether the 64 bit word
+    // below it has anything set, so finding the nearest set bit in either direction is at most three word scans with
+    // countl_zero/countr_zero whatever the distance.
+    class LevelBitmap final {
+    public:
+        static constexpr size_t npos = std::numeric_limits<size_t>::max();
+        static constexpr size_t MaxBits = 64 * 64 * 64;
+
+        explicit LevelBitmap(size_t num_bits)
+            : num_bits_(num_bits), words_((num_bits + 63) / 64, 0), summary_((words_.size() + 63) / 64, 0) {
+            ASSERT(num_bits_ && num_bits_ <= MaxBits, "LevelBitmap size out of range:" + std::to_string(num_bits_));
+        }
+
+        auto size() const noexcept {
+            return num_bits_;
+        }
+
+        auto test(size_t i) const noexcept {
+            return (words_[i >> 6] >> (i & 63)) & 1;
+        }
+
+        auto set(size_t i) noexcept {
+            words_[i >> 6] |= 1ULL << (i & 63);
+            summary_[i >> 12] |= 1ULL << ((i >> 6) & 63);
+            top_ |= 1ULL << (i >> 12);
+        }
+
+        auto clear(size_t i) noexcept {
+            words_[i >> 6] &= ~(1ULL << (i & 63));
+            if (!words_[i >> 6]) {
+                summary_[i >> 12] &= ~(1ULL << ((i >> 6) & 63));
+                if (!summary_[i >> 12])
+                    top_ &= ~(1ULL << (i >> 12));
+            }
+        }
+
+        auto empty() const noexcept {
+            return !top_;
+        }
+
+        // Highest set bit at or below i.
+        auto findLastAtOrBelow(size_t i) const noexcept -> size_t {
+            if (UNLIKELY(i == npos))
+                return npos;
+            i = std::min(i, num_bits_ - 1);
+
+            const auto word = i >> 6;
+            if (const auto bits = words_[word] & upTo(i & 63))
+                return (word << 6) + highest(bits);
+
+            const auto group = word >> 6;
+            if (const auto bits = summary_[group] & below(word & 63))
+                return lastInWord((group << 6) + highest(bits));
+
+            if (const auto bits = top_ & below(group)) {
+                const auto prev_group = highest(bits);
+                return lastInWord((prev_group << 6) + highest(summary_[prev_group]));
+            }
+            return npos;
+        }
+
+        // Lowest set bit at or above i.
+        auto findFirstAtOrAbove(size_t i) const noexcept -> size_t {
+            if (UNLIKELY(i >= num_bits_))
+                return npos;
+
+            const auto word = i >> 6;
+            if (const auto bits = words_[word] & from(i & 63))
+                return (word << 6) + lowest(bits);
+
+            const auto group = word >> 6;
+            if (const auto bits = summary_[group] & above(word & 63))
+                return firstInWord((group << 6) + lowest(bits));
+
+            if (const auto bits = top_ & above(group)) {
+                const auto next_group = lowest(bits);
+                return firstInWord((next_group << 6) + lowest(summary_[next_group]));
+            }
+            return npos;
+        }
+
+    private:
+        static constexpr auto highest(uint64_t bits) noexcept -> size_t {
+            return 63 - std::countl_zero(bits);
+        }
+
+        static constexpr auto lowest(uint64_t bits) noexcept -> size_t {
+            return std::countr_zero(bits);
+        }
+
+        static constexpr auto upTo(size_t b) noexcept -> uint64_t {
+            return b == 63 ? ~0ULL : (2ULL << b) - 1;
+        }
+
+        static constexpr auto below(size_t b) noexcept -> uint64_t {
+            return (1ULL << b) - 1;
+        }
+
+        static constexpr auto from(size_t b) noexcept -> uint64_t {
+            return ~0ULL << b;
+        }
+
+        static constexpr auto above(size_t b) noexcept -> uint64_t {
+            return b == 63 ? 0 : ~0ULL << (b + 1);
+        }
+
+        auto lastInWord(size_t word) const noexcept -> size_t {
+            return (word << 6) + highest(words_[word]);
+        }
+
+        auto firstInWord(size_t word) const noexcept -> size_t {
+            return (word << 6) + lowest(words_[word]);
+        }
+
+        const size_t num_bits_;
+        std::vector<uint64_t> words_;
+        std::vector<uint64_t> summary_;
+        uint64_t top_ = 0;
+    };
+}
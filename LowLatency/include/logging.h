@@ -4,14 +4,20 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <fstream>
+#include <sstream>
 #include <cstdio>
+#include <type_traits>
+#include <concepts>
+#include <unordered_map>
 
 
 #include "macros.h"
-#include "lf_queue.h"
+#include "spsc_queue.h"
 #include "thread_utils.h"
 #include "time_utils.h"
+#include "idle_strategy.h"
 
 namespace LL::Common {
     constexpr size_t LOG_QUEUE_SIZE = 8 * 1024 * 1024;
@@ -26,94 +32,238 @@ namespace LL::Common {
         UNSIGNED_LONG_LONG_INTEGER = 6,
         FLOAT = 7,
         DOUBLE = 8,
+        STRING = 9,
+        OBJECT = 10,
     };
 
-    struct LogElement {
-        LogType type_ = LogType::CHAR;
-
-        union {
-            char char_;
-            int int_;
-            long long_;
-            long long llong_;
-            unsigned u_;
-            unsigned long ulong_;
-            unsigned long long ullong_;
-            float float_;
-            double double_;
-        } union_;
+    // TEXT formats every record on the logger thread. BINARY writes the raw records plus a table of format strings
+    // and leaves the formatting to log_decoder.
+    enum class LogFormat: int8_t {
+        TEXT = 0,
+        BINARY = 1,
     };
 
+    enum class LogEntryKind: uint8_t {
+        FORMAT = 1,
+        RECORD = 2,
+    };
+
+    constexpr char LOG_BINARY_MAGIC[8] = {'L', 'L', 'B', 'L', 'O', 'G', '\0', '\1'};
+
+    using LogObjectFormatter = void (*)(std::ostream &os, const void *data);
+
+    template<typename T>
+    concept LogString = std::is_convertible_v<const T &, std::string_view>;
+
+    template<typename T>
+    concept LogObject = !LogString<T> && std::is_trivially_copyable_v<T> && requires(const T &value) {
+        { value.toString() } -> std::convertible_to<std::string>;
+    };
+
+    // A log call becomes one record made of whole LogSlots: the header below followed by every argument encoded as
+    // a LogType tag and its raw bytes. Format strings are referenced by address and must be string literals.
+    struct LogRecordHeader {
+        const char *format_ = nullptr;
+        uint64_t tsc_ = 0;
+        uint32_t payload_size_ = 0;
+        uint32_t num_slots_ = 0;
+    };
+
+    struct LogSlot {
+        char data_[CACHE_LINE_SIZE];
+    };
+
+    template<typename T>
+    inline constexpr auto logTypeOf() noexcept {
+        using U = std::remove_cv_t<T>;
+        if constexpr (std::is_same_v<U, char>)
+            return LogType::CHAR;
+        else if constexpr (std::is_same_v<U, float>)
+            return LogType::FLOAT;
+        else if constexpr (std::is_floating_point_v<U>)
+            return LogType::DOUBLE;
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+            return sizeof(U) <= sizeof(int) ? LogType::INTEGER : LogType::LONG_LONG_INTEGER;
+        else if constexpr (std::is_integral_v<U>)
+            return sizeof(U) <= sizeof(unsigned) ? LogType::UNSIGNED_INTEGER : LogType::UNSIGNED_LONG_LONG_INTEGER;
+        else
+            static_assert(!sizeof(U), "Unsupported log argument type.");
+    }
+
+    inline constexpr auto logTypeSize(LogType type) noexcept -> size_t {
+        switch (type) {
+            case LogType::CHAR:
+                return sizeof(char);
+            case LogType::INTEGER:
+                return sizeof(int);
+            case LogType::LONG_INTEGER:
+                return sizeof(long);
+            case LogType::LONG_LONG_INTEGER:
+                return sizeof(long long);
+            case LogType::UNSIGNED_INTEGER:
+                return sizeof(unsigned);
+            case LogType::UNSIGNED_LONG_INTEGER:
+                return sizeof(unsigned long);
+            case LogType::UNSIGNED_LONG_LONG_INTEGER:
+                return sizeof(unsigned long long);
+            case LogType::FLOAT:
+                return sizeof(float);
+            case LogType::DOUBLE:
+                return sizeof(double);
+            case LogType::STRING:
+            case LogType::OBJECT:
+                break;
+        }
+        return 0;
+    }
+
+    template<typename T>
+    inline auto encodedSize(const T &value) noexcept -> size_t {
+        if constexpr (LogString<T>)
+            return sizeof(LogType) + sizeof(uint32_t) + std::string_view(value).size();
+        else if constexpr (LogObject<T>)
+            return sizeof(LogType) + sizeof(LogObjectFormatter) + sizeof(uint32_t) + sizeof(T);
+        else
+            return sizeof(LogType) + logTypeSize(logTypeOf<T>());
+    }
+
+    inline auto logArgumentSize(const char *arg) noexcept -> size_t {
+        const auto type = static_cast<LogType>(*arg);
+        uint32_t len = 0;
+        switch (type) {
+            case LogType::STRING:
+                memcpy(&len, arg + sizeof(LogType), sizeof(len));
+                return sizeof(LogType) + sizeof(len) + len;
+            case LogType::OBJECT:
+                memcpy(&len, arg + sizeof(LogType) + sizeof(LogObjectFormatter), sizeof(len));
+                return sizeof(LogType) + sizeof(LogObjectFormatter) + sizeof(len) + len;
+            default:
+                return sizeof(LogType) + logTypeSize(type);
+        }
+    }
+
+    template<typename T>
+    inline auto readPayload(const char *payload, size_t *pos) noexcept {
+        T value;
+        memcpy(&value, payload + *pos, sizeof(T));
+        *pos += sizeof(T);
+        return value;
+    }
+
+    // Prints the argument at *pos and moves *pos past it. OBJECT arguments are only valid inside the process which
+    // wrote them, since they carry the address of their formatter.
+    inline auto formatLogArgument(std::ostream &os, const char *payload, size_t *pos) noexcept {
+        const auto type = readPayload<LogType>(payload, pos);
+        switch (type) {
+            case LogType::CHAR:
+                os << readPayload<char>(payload, pos);
+                break;
+            case LogType::INTEGER:
+                os << readPayload<int>(payload, pos);
+                break;
+            case LogType::LONG_INTEGER:
+                os << readPayload<long>(payload, pos);
+                break;
+            case LogType::LONG_LONG_INTEGER:
+                os << readPayload<long long>(payload, pos);
+                break;
+            case LogType::UNSIGNED_INTEGER:
+                os << readPayload<unsigned>(payload, pos);
+                break;
+            case LogType::UNSIGNED_LONG_INTEGER:
+                os << readPayload<unsigned long>(payload, pos);
+                break;
+            case LogType::UNSIGNED_LONG_LONG_INTEGER:
+                os << readPayload<unsigned long long>(payload, pos);
+                break;
+            case LogType::FLOAT:
+                os << readPayload<float>(payload, pos);
+                break;
+            case LogType::DOUBLE:
+                os << readPayload<double>(payload, pos);
+                break;
+            case LogType::STRING: {
+                const auto len = readPayload<uint32_t>(payload, pos);
+                os.write(payload + *pos, len);
+                *pos += len;
+            }
+            break;
+            case LogType::OBJECT: {
+                const auto formatter = readPayload<LogObjectFormatter>(payload, pos);
+                const auto len = readPayload<uint32_t>(payload, pos);
+                formatter(os, payload + *pos);
+                *pos += len;
+            }
+            break;
+            default:
+                FATAL("Unknown LogType");
+                break;
+        }
+    }
+
+    inline auto formatLogRecord(std::ostream &os, const char *format,
+                                const char *payload, size_t payload_size) noexcept {
+        size_t pos = 0;
+        for (auto s = format; *s; ++s) {
+            if (*s == '%') {
+                if (UNLIKELY(*(s + 1) == '%')) {
+                    ++s;
+                } else {
+                    if (UNLIKELY(pos >= payload_size))
+                        FATAL("no arguments provided to log()");
+                    formatLogArgument(os, payload, &pos);
+                    continue;
+                }
+            }
+            os << *s;
+        }
+        if (UNLIKELY(pos != payload_size))
+            FATAL("extra arguments provided to log()");
+    }
 
     class Logger final {
     public:
         auto flushQueue() noexcept {
             while (running_) {
-                for (auto next = queue_.getNextToRead();
-                     queue_.size() && next; next = queue_.getNextToRead()) {
-                    switch (next->type_) {
-                        case LogType::CHAR: {
-                            file_ << next->union_.char_;
-                            break;
-                        }
-
-                        case LogType::INTEGER: {
-                            file_ << next->union_.int_;
-                            break;
-                        }
-
-                        case LogType::LONG_INTEGER: {
-                            file_ << next->union_.long_;
-                            break;
-                        }
-
-                        case LogType::LONG_LONG_INTEGER: {
-                            file_ << next->union_.llong_;
-                            break;
-                        }
-
-                        case LogType::UNSIGNED_INTEGER: {
-                            file_ << next->union_.u_;
-                            break;
-                        }
-
-                        case LogType::UNSIGNED_LONG_INTEGER: {
-                            file_ << next->union_.ulong_;
-                            break;
-                        }
-
-                        case LogType::UNSIGNED_LONG_LONG_INTEGER: {
-                            file_ << next->union_.ullong_;
-                            break;
-                        }
-
-                        case LogType::FLOAT: {
-                            file_ << next->union_.float_;
-                            break;
-                        }
-
-                        case LogType::DOUBLE: {
-                            file_ << next->union_.double_;
-                            break;
-                        }
-
-                        default: {
-                            ASSERT(false, "Unknown LogType");
-                            break;
-                        }
-                    }
-                    queue_.updateReadIndex();
+                const auto num_slots = queue_.peek(queue_.capacity());
+                size_t slot = 0;
+                while (slot < num_slots) {
+                    LogRecordHeader header;
+                    readBytes(slot * sizeof(LogSlot), &header, sizeof(header));
+
+                    payload_.resize(header.payload_size_);
+                    readBytes(slot * sizeof(LogSlot) + sizeof(header), payload_.data(), header.payload_size_);
+
+                    if (format_ == LogFormat::TEXT)
+                        formatLogRecord(file_, header.format_, payload_.data(), payload_.size());
+                    else
+                        writeBinaryRecord(header);
+
+                    slot += header.num_slots_;
+                }
+                if (num_slots) {
+                    queue_.consume(num_slots);
+                    file_.flush();
                 }
-                file_.flush();
 
-                using namespace std::chrono_literals;
-                std::this_thread::sleep_for(10ms);
+                idle_strategy_.idle(num_slots);
             }
         }
 
-        explicit Logger(const std::string &file_name) : file_name_(file_name), queue_(LOG_QUEUE_SIZE) {
-            file_.open(file_name);
+        // PARK makes every log() call pay for a fence to check for a parked flusher, so hot threads' loggers should
+        // stay on BACKOFF.
+        explicit Logger(const std::string &file_name, LogFormat format = LogFormat::TEXT,
+                        IdleStrategyType idle_type = IdleStrategyType::BACKOFF)
+            : file_name_(file_name), format_(format), queue_(LOG_QUEUE_SIZE / sizeof(LogSlot)),
+              idle_strategy_(idle_type, idle_type == IdleStrategyType::PARK ? queue_.getWakeSignal() : nullptr) {
+            file_.open(file_name, format_ == LogFormat::BINARY ? std::ios::binary | std::ios::out : std::ios::out);
             ASSERT(file_.is_open(), "Could not open log file:" + file_name);
+            if (format_ == LogFormat::BINARY)
+                file_.write(LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC));
+
+            // Calibrate the TSC clock here rather than on the first latency probe of a hot thread.
+            TSCClock::instance();
+
             logger_thread_ = createAndStartThread(-1, "Common/Logger " +
                                                       file_name_, [this]() { flushQueue(); });
             ASSERT(logger_thread_ != nullptr, "Could not create logger thread");;
@@ -134,103 +284,156 @@ namespace LL::Common {
             std::cerr << getCurrentTimeStr(&time_str) << " Logger for " << file_name_ << " is done" << std::endl;
         }
 
-        auto pushValue(const LogElement &log_element) noexcept {
-            *(queue_.getNextToWriteTo()) = log_element;
-            queue_.updateWriteIndex();
-        }
-
-        auto pushValue(const char value) noexcept {
-            pushValue(LogElement{LogType::CHAR, .union_ = {.char_ = value}});
-        }
+        template<typename... A>
+        auto log(const char *s, const A &... args) noexcept {
+            const auto payload_size = (encodedSize(args) + ... + 0);
+            const auto num_slots = (sizeof(LogRecordHeader) + payload_size + sizeof(LogSlot) - 1) / sizeof(LogSlot);
+            if (UNLIKELY(num_slots > queue_.capacity()))
+                FATAL("log() record larger than the log queue, bytes:" + std::to_string(payload_size));
 
-        auto pushValue(const int value) noexcept {
-            pushValue(LogElement{LogType::INTEGER, .union_ = {.int_ = value}});
-        }
+            while (UNLIKELY(queue_.reserve(num_slots) < num_slots))
+                cpuPause();
 
-        auto pushValue(const long value) noexcept {
-            pushValue(LogElement{LogType::LONG_INTEGER, .union_ = {.long_ = value}});
-        }
+            const LogRecordHeader header{s, rdtsc(), static_cast<uint32_t>(payload_size),
+                                         static_cast<uint32_t>(num_slots)};
+            size_t offset = 0;
+            writeBytes(&offset, &header, sizeof(header));
+            (pushValue(&offset, args), ...);
 
-        auto pushValue(const long long value) noexcept {
-            pushValue(LogElement{LogType::LONG_LONG_INTEGER, .union_ = {.llong_ = value}});
+            queue_.publish(num_slots);
         }
 
-        auto pushValue(const unsigned value) noexcept {
-            pushValue(LogElement{LogType::UNSIGNED_INTEGER, .union_ = {.u_ = value}});
-        }
+        Logger() = delete;
 
-        auto pushValue(const unsigned long value) noexcept {
-            pushValue(LogElement{LogType::UNSIGNED_LONG_INTEGER, .union_ = {.ulong_ = value}});
-        }
+        Logger(const Logger &) = delete;
 
-        auto pushValue(const unsigned long long value) noexcept {
-            pushValue(LogElement{LogType::UNSIGNED_LONG_LONG_INTEGER, .union_ = {.ullong_ = value}});
-        }
+        Logger(const Logger &&) = delete;
 
-        auto pushValue(const float value) noexcept {
-            pushValue(LogElement{LogType::FLOAT, .union_ = {.float_ = value}});
-        }
+        Logger &operator=(const Logger &) = delete;
 
-        auto pushValue(const double value) noexcept {
-            pushValue(LogElement{LogType::DOUBLE, .union_ = {.double_ = value}});
-        }
+        Logger &operator=(const Logger &&) = delete;
 
-        auto pushValue(const char *value) noexcept {
-            while (*value) {
-                pushValue(*value);
-                ++value;
+    private:
+        auto writeBytes(size_t *offset, const void *data, size_t len) noexcept -> void {
+            auto src = static_cast<const char *>(data);
+            while (len) {
+                const auto in_slot = *offset % sizeof(LogSlot);
+                const auto n = std::min(len, sizeof(LogSlot) - in_slot);
+                memcpy(queue_.getWriteSlot(*offset / sizeof(LogSlot))->data_ + in_slot, src, n);
+                *offset += n;
+                src += n;
+                len -= n;
             }
         }
 
-        auto pushValue(const std::string &value) noexcept {
-            pushValue(value.c_str());
-        }
-
-        template<class T, typename... A>
-        auto log(const char *s, const T &value, A... args) noexcept {
-            while (*s) {
-                if (*s == '%') {
-                    if (UNLIKELY(*(s + 1) == '%'))
-                        ++s;
-                    else {
-                        pushValue(value);
-                        log(s + 1, args...);
-                        return;
-                    }
-                }
-                pushValue(*s);
+        auto readBytes(size_t offset, void *data, size_t len) noexcept -> void {
+            auto dst = static_cast<char *>(data);
+            while (len) {
+                const auto in_slot = offset % sizeof(LogSlot);
+                const auto n = std::min(len, sizeof(LogSlot) - in_slot);
+                memcpy(dst, queue_.getReadSlot(offset / sizeof(LogSlot))->data_ + in_slot, n);
+                offset += n;
+                dst += n;
+                len -= n;
             }
-            FATAL("extra arguments provided to log()");
         }
 
-        auto log(const char *s) noexcept {
-            while (*s) {
-                if (*s == '%') {
-                    if (UNLIKELY(*(s + 1) == '%'))
-                        ++s;
-                    else
-                        FATAL("no arguments provided to log()");
+        template<typename T>
+        auto pushValue(size_t *offset, const T &value) noexcept -> void {
+            if constexpr (LogString<T>) {
+                const std::string_view str(value);
+                const auto type = LogType::STRING;
+                const auto len = static_cast<uint32_t>(str.size());
+                writeBytes(offset, &type, sizeof(type));
+                writeBytes(offset, &len, sizeof(len));
+                writeBytes(offset, str.data(), len);
+            } else if constexpr (LogObject<T>) {
+                const auto type = LogType::OBJECT;
+                const LogObjectFormatter formatter = [](std::ostream &os, const void *data) {
+                    T object;
+                    memcpy(&object, data, sizeof(T));
+                    os << object.toString();
+                };
+                const auto len = static_cast<uint32_t>(sizeof(T));
+                writeBytes(offset, &type, sizeof(type));
+                writeBytes(offset, &formatter, sizeof(formatter));
+                writeBytes(offset, &len, sizeof(len));
+                writeBytes(offset, &value, sizeof(T));
+            } else {
+                constexpr auto type = logTypeOf<T>();
+                writeBytes(offset, &type, sizeof(type));
+                if constexpr (type == LogType::INTEGER) {
+                    const int v = value;
+                    writeBytes(offset, &v, sizeof(v));
+                } else if constexpr (type == LogType::LONG_LONG_INTEGER) {
+                    const long long v = value;
+                    writeBytes(offset, &v, sizeof(v));
+                } else if constexpr (type == LogType::UNSIGNED_INTEGER) {
+                    const unsigned v = value;
+                    writeBytes(offset, &v, sizeof(v));
+                } else if constexpr (type == LogType::UNSIGNED_LONG_LONG_INTEGER) {
+                    const unsigned long long v = value;
+                    writeBytes(offset, &v, sizeof(v));
+                } else if constexpr (type == LogType::DOUBLE) {
+                    const double v = value;
+                    writeBytes(offset, &v, sizeof(v));
+                } else {
+                    writeBytes(offset, &value, sizeof(value));
                 }
-                pushValue(*s++);
             }
         }
 
-        Logger() = delete;
-
-        Logger(const Logger &) = delete;
-
-        Logger(const Logger &&) = delete;
+        // OBJECT arguments are rendered to STRING here so that the file can be decoded by another process.
+        auto writeBinaryRecord(const LogRecordHeader &header) noexcept -> void {
+            auto format_itr = format_ids_.find(header.format_);
+            if (format_itr == format_ids_.end()) {
+                format_itr = format_ids_.emplace(header.format_, static_cast<uint32_t>(format_ids_.size())).first;
+                const auto kind = LogEntryKind::FORMAT;
+                const auto len = static_cast<uint32_t>(strlen(header.format_));
+                file_.write(reinterpret_cast<const char *>(&kind), sizeof(kind));
+                file_.write(reinterpret_cast<const char *>(&format_itr->second), sizeof(format_itr->second));
+                file_.write(reinterpret_cast<const char *>(&len), sizeof(len));
+                file_.write(header.format_, len);
+            }
 
-        Logger &operator=(const Logger &) = delete;
+            binary_payload_.clear();
+            for (size_t pos = 0; pos < payload_.size();) {
+                const auto start = pos;
+                if (static_cast<LogType>(payload_[pos]) == LogType::OBJECT) {
+                    std::ostringstream ss;
+                    formatLogArgument(ss, payload_.data(), &pos);
+                    const auto str = ss.str();
+                    const auto type = LogType::STRING;
+                    const auto len = static_cast<uint32_t>(str.size());
+                    binary_payload_.append(reinterpret_cast<const char *>(&type), sizeof(type));
+                    binary_payload_.append(reinterpret_cast<const char *>(&len), sizeof(len));
+                    binary_payload_.append(str);
+                } else {
+                    pos += logArgumentSize(payload_.data() + pos);
+                    binary_payload_.append(payload_.data() + start, pos - start);
+                }
+            }
 
-        Logger &operator=(const Logger &&) = delete;
+            const auto kind = LogEntryKind::RECORD;
+            const auto payload_size = static_cast<uint32_t>(binary_payload_.size());
+            file_.write(reinterpret_cast<const char *>(&kind), sizeof(kind));
+            file_.write(reinterpret_cast<const char *>(&format_itr->second), sizeof(format_itr->second));
+            file_.write(reinterpret_cast<const char *>(&header.tsc_), sizeof(header.tsc_));
+            file_.write(reinterpret_cast<const char *>(&payload_size), sizeof(payload_size));
+            file_.write(binary_payload_.data(), payload_size);
+        }
 
-    private:
         const std::string file_name_;
+        const LogFormat format_;
         std::ofstream file_;
 
-        LFQueue<LogElement> queue_;
+        SPSCQueue<LogSlot> queue_;
+        IdleStrategy idle_strategy_;
         std::atomic<bool> running_ = {true};
         std::thread *logger_thread_ = {nullptr};
+
+        std::string payload_;
+        std::string binary_payload_;
+        std::unordered_map<const char *, uint32_t> format_ids_;
     };
 }
@@ -10,6 +10,15 @@ namespace LL::Common {
 #define LIKELY(x) __builtin_expect(!!(x), 1)
 #define UNLIKELY(x) __builtin_expect(!!(x), 0)
 
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    inline constexpr auto roundUpToPowerOfTwo(size_t n) noexcept {
+        size_t ret = 1;
+        while (ret < n)
+            ret <<= 1;
+        return ret;
+    }
+
     inline auto ASSERT(bool cond, const std::string &msg) noexcept {
         if (UNLIKELY(!cond)) {
             std::cerr << "ASSERT : " << msg << std::endl;
@@ -6,17 +6,21 @@
 
 
 #include <functional>
+#include "perf_utils.h"
+#include "idle_strategy.h"
 #include "snapshot_synthesizer.h"
+#include "md_packetizer.h"
 
 namespace LL::Exchange {
     class MarketDataPublisher {
     public:
-        MarketDataPublisher(MEMarketUpdateLFQueue *market_updates,
+        MarketDataPublisher(MEMarketUpdateRing *market_updates,
                             const std::string &iface,
                             const std::string &snapshot_ip,
                             int snapshot_port,
                             const std::string &incremental_ip,
-                            int incremental_port);
+                            int incremental_port,
+                            const InstrumentRegistry &instruments = InstrumentRegistry::uniform(ME_MAX_TICKERS));
 
         ~MarketDataPublisher();
 
@@ -24,6 +28,14 @@ namespace LL::Exchange {
 
         auto stop() -> void;
 
+        // Must be called before start(), applies to both the incremental publisher and the snapshot synthesizer.
+        auto setIdleStrategy(IdleStrategyType publisher_type, IdleStrategyType snapshot_type) -> void;
+
+        // Must be called before start(), encoding of the incremental feed.
+        auto setPacketFormat(MDPacketFormat format) -> void {
+            incremental_packetizer_.setFormat(format);
+        }
+
         auto run() noexcept -> void;
 
         MarketDataPublisher() = delete;
@@ -38,14 +50,16 @@ namespace LL::Exchange {
 
     private:
         size_t next_inc_seq_num_{1};
-        MEMarketUpdateLFQueue *outgoing_md_updates_ = nullptr;
-        MDPMarketUpdateLFQueue snapshot_md_updates_;
+        MEMarketUpdateRing *outgoing_md_updates_ = nullptr;
+        MEMarketUpdateRing::ConsumerId md_consumer_id_ = 0;
 
         volatile bool run_{false};
+        IdleStrategy idle_strategy_;
         std::string time_str_;
         Logger logger_;
 
         McastSocket incremental_socket_;
+        MDPacketizer incremental_packetizer_;
         SnapshotSynthesizer *snapshot_synthesizer_ = nullptr;
     };
 }
@@ -7,6 +7,8 @@
 #include <sstream>
 
 #include "types.h"
+#include "spsc_queue.h"
+#include "broadcast_ring.h"
 
 using namespace LL::Common;
 
@@ -44,6 +46,23 @@ namespace LL::Exchange {
         return "UNKNOWN";
     }
 
+    // Encoding of the updates in a market data packet, RAW carries MDPMarketUpdate records as they are, COMPACT the
+    // variable length records of md_compact_codec.h.
+    enum class MDPacketFormat : uint8_t {
+        RAW = 0,
+        COMPACT = 1
+    };
+
+    inline std::string mdPacketFormatToString(MDPacketFormat format) {
+        switch (format) {
+            case MDPacketFormat::RAW:
+                return "RAW";
+            case MDPacketFormat::COMPACT:
+                return "COMPACT";
+        }
+        return "UNKNOWN";
+    }
+
 #pragma pack(push, 1)
     struct MEMarketUpdate {
         MarketUpdateType type_ = MarketUpdateType::INVALID;
@@ -82,8 +101,26 @@ namespace LL::Exchange {
             return ss.str();
         }
     };
+
+    // Leads every market data datagram, followed by length_ bytes holding num_updates_ updates in sequence order.
+    struct MDPacketHeader {
+        size_t first_seq_num_{0};
+        uint16_t num_updates_{0};
+        uint16_t length_{0};
+        MDPacketFormat format_{MDPacketFormat::RAW};
+
+        auto toString() const {
+            std::stringstream ss;
+            ss << "MDPacketHeader" << " [" << " first_seq: " << first_seq_num_
+                    << " num_updates: " << num_updates_
+                    << " length: " << length_
+                    << " format: " << mdPacketFormatToString(format_) << "]";
+            return ss.str();
+        }
+    };
 #pragma  pack(pop)
 
-    using MEMarketUpdateLFQueue = LFQueue<MEMarketUpdate>;
-    using MDPMarketUpdateLFQueue = LFQueue<MDPMarketUpdate>;
+    using MEMarketUpdateLFQueue = SPSCQueue<MEMarketUpdate>;
+    using MDPMarketUpdateLFQueue = SPSCQueue<MDPMarketUpdate>;
+    using MEMarketUpdateRing = BroadcastRing<MEMarketUpdate>;
 }
@@ -5,24 +5,50 @@
 #pragma once
 
 #include "thread_utils.h"
-#include "lf_queue.h"
+#include "spsc_queue.h"
 #include "macros.h"
+#include "perf_utils.h"
+#include "idle_strategy.h"
 
 #include  "client_request.h"
 #include "client_response.h"
 #include "market_update.h"
 
+#include "instrument_registry.h"
 #include "me_order_book.h"
 
 
 using namespace LL::Common;
 
 namespace LL::Exchange {
+    // A book left empty and without requests for this long is released.
+    constexpr Nanos ME_BOOK_RELEASE_DELAY = 10 * NANOS_TO_SECS;
+    // Output slots reserved per request at the start of a batch, a batch producing more reserves again.
+    constexpr size_t ME_BATCH_OUTPUTS_PER_REQUEST = 4;
+
+    // Books are opened on the first request for a registered instrument, sized from its InstrumentCfg, and released
+    // once they have sat empty for ME_BOOK_RELEASE_DELAY, so memory follows the active instruments rather than the
+    // whole universe. Requests for unregistered tickers are dropped, cancels on a ticker without a book are rejected
+    // without opening one.
     class MatchingEngine final {
     public:
         MatchingEngine(ClientRequestLFQueue *client_requests,
                        ClientResponseLFQueue *client_responses,
-                       MEMarketUpdateLFQueue *market_updates);
+                       MEMarketUpdateRing *market_updates,
+                       const InstrumentRegistry &instruments = InstrumentRegistry::uniform(ME_MAX_TICKERS));
+
+        MatchingEngine(ClientRequestMPSCQueue *client_requests,
+                       ClientResponseLFQueue *client_responses,
+                       MEMarketUpdateRing *market_updates,
+                       const InstrumentRegistry &instruments = InstrumentRegistry::uniform(ME_MAX_TICKERS));
+
+        // One shard of a ShardedMatchingEngine, only requests for the shard's tickers may be queued. The thread, log
+        // file and metrics are suffixed with the shard number.
+        MatchingEngine(ClientRequestLFQueue *client_requests,
+                       ClientResponseLFQueue *client_responses,
+                       MEMarketUpdateRing *market_updates,
+                       const InstrumentRegistry &instruments,
+                       size_t shard);
 
         ~MatchingEngine();
 
@@ -30,8 +56,25 @@ namespace LL::Exchange {
 
         auto stop() -> void;
 
+        // Must be called before start(), PARK sleeps on the incoming request queue until a producer publishes.
+        auto setIdleStrategy(IdleStrategyType type) -> void;
+
+        // Must be called before start(). With a batch size each pass drains up to batch_size requests, writes their
+        // responses and market updates straight into reserved queue slots and publishes each queue once at the end of
+        // the pass; requests and outputs are then logged once per batch instead of once per message. 0, the default,
+        // processes and publishes one message at a time.
+        auto setBatchSize(size_t batch_size) -> void;
+
         auto processClientRequest(const MEClientRequest *client_request) noexcept {
-            auto order_book = ticker_order_books_[client_request->ticker_id_];
+            const auto ticker_id = client_request->ticker_id_;
+            auto order_book = LIKELY(ticker_id < books_.size()) ? books_[ticker_id].book_ : nullptr;
+            if (UNLIKELY(!order_book)) {
+                order_book = openOrderBook(client_request);
+                if (!order_book)
+                    return;
+            }
+            ++books_[ticker_id].requests_;
+
             switch (client_request->type_) {
                 case ClientRequestType::NEW: {
                     order_book->add(
@@ -58,25 +101,100 @@ namespace LL::Exchange {
         }
 
         auto sendClientResponse(const MEClientResponse *client_response) noexcept {
+            if (batch_size_) {
+                if (UNLIKELY(pending_responses_ == reserved_responses_))
+                    reserveResponses();
+                *outgoing_ogw_responses_->getWriteSlot(pending_responses_++) = *client_response;
+                return;
+            }
+
             logger_.log("%:% %() % Sending %\n",
                         __FILE__,
                         __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_),
-                        client_response->toString());
+                        *client_response);
             auto next_write = outgoing_ogw_responses_->getNextToWriteTo();
             *next_write = std::move(*client_response);
             outgoing_ogw_responses_->updateWriteIndex();
+            TTT_MEASURE(T4t_MatchingEngine_LFQueue_write, logger_);
         }
 
         auto sendMarketUpdate(const MEMarketUpdate *market_update) noexcept {
+            if (batch_size_) {
+                if (UNLIKELY(pending_market_updates_ == reserved_market_updates_))
+                    reserveMarketUpdates();
+                *outgoing_md_updates_->getWriteSlot(pending_market_updates_++) = *market_update;
+                return;
+            }
+
             logger_.log("%:% %() % Sending %\n",
                         __FILE__,
                         __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_),
-                        market_update->toString());
+                        *market_update);
             auto next_write = outgoing_md_updates_->getNextToWriteTo();
             *next_write = *market_update;
             outgoing_md_updates_->updateWriteIndex();
+            TTT_MEASURE(T4_MatchingEngine_LFQueue_write, logger_);
+        }
+
+        template<typename Q>
+        auto drainRequests(Q *requests) noexcept {
+            if (batch_size_)
+                return drainBatch(requests);
+
+            const auto num_requests = requests->peek(requests->capacity());
+            for (size_t i = 0; i < num_requests; ++i) {
+                const auto me_client_request = requests->getReadSlot(i);
+                TTT_MEASURE(T3_MatchingEngine_LFQueue_read, logger_);
+                logger_.log("%:% %() % Processing %\n",
+                            __FILE__,
+                            __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_),
+                            *me_client_request);
+                START_MEASURE(Exchange_MatchingEngine_processClientRequest);
+                processClientRequest(me_client_request);
+                RECORD_MEASURE(Exchange_MatchingEngine_processClientRequest, process_request_latency_);
+            }
+            if (num_requests) {
+                requests->consume(num_requests);
+                request_queue_depth_->record(num_requests);
+                requests_processed_->add(num_requests);
+            }
+            return num_requests;
+        }
+
+        template<typename Q>
+        auto drainBatch(Q *requests) noexcept {
+            const auto num_requests = requests->peek(batch_size_);
+            if (!num_requests)
+                return num_requests;
+
+            START_MEASURE(Exchange_MatchingEngine_processBatch);
+            TTT_MEASURE(T3_MatchingEngine_LFQueue_read, logger_);
+            reserved_responses_ = outgoing_ogw_responses_->reserve(num_requests * ME_BATCH_OUTPUTS_PER_REQUEST);
+            reserved_market_updates_ = outgoing_md_updates_->reserve(num_requests * ME_BATCH_OUTPUTS_PER_REQUEST);
+            for (size_t i = 0; i < num_requests; ++i) {
+                START_MEASURE(Exchange_MatchingEngine_processClientRequest);
+                processClientRequest(requests->getReadSlot(i));
+                RECORD_MEASURE(Exchange_MatchingEngine_processClientRequest, process_request_latency_);
+            }
+            requests->consume(num_requests);
+
+            const auto num_responses = batch_responses_flushed_ + pending_responses_;
+            const auto num_market_updates = batch_market_updates_flushed_ + pending_market_updates_;
+            publishBatch();
+            TTT_MEASURE(T4_MatchingEngine_LFQueue_write, logger_);
+            RECORD_MEASURE(Exchange_MatchingEngine_processBatch, batch_latency_);
+
+            logger_.log("%:% %() % Batch requests:% responses:% market_updates:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), num_requests, num_responses, num_market_updates);
+            request_queue_depth_->record(num_requests);
+            requests_processed_->add(num_requests);
+            batch_responses_->record(num_responses);
+            batch_market_updates_->record(num_market_updates);
+            return num_requests;
         }
 
         auto run() noexcept {
@@ -85,16 +203,16 @@ namespace LL::Exchange {
                         __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_));
             while (run_) {
-                const auto me_client_request = incoming_requests_->getNextToRead();
-                if (LIKELY(me_client_request)) {
-                    logger_.log("%:% %() % Processing %\n",
-                                __FILE__,
-                                __LINE__, __FUNCTION__,
-                                getCurrentTimeStr(&time_str_),
-                                me_client_request->toString());
-                    processClientRequest(me_client_request);
-                    incoming_requests_->updateReadIndex();
-                }
+                size_t num_requests = 0;
+                if (incoming_requests_)
+                    num_requests += drainRequests(incoming_requests_);
+                if (incoming_gateway_requests_)
+                    num_requests += drainRequests(incoming_gateway_requests_);
+
+                requests_since_release_check_ += num_requests;
+                if (!num_requests || UNLIKELY(requests_since_release_check_ >= 64 * 1024))
+                    releaseIdleOrderBooks();
+                idle_strategy_.idle(num_requests);
             }
         }
 
@@ -109,15 +227,68 @@ namespace LL::Exchange {
         auto operator=(const MatchingEngine &&) -> MatchingEngine & = delete;
 
     private:
-        OrderBookHashMap ticker_order_books_;
+        struct BookSlot {
+            MEOrderBook *book_ = nullptr;
+            // Carried across a release so a reopened book keeps issuing fresh market order ids.
+            OrderId next_market_order_id_ = 1;
+            size_t requests_ = 0;
+            size_t requests_at_release_check_ = 0;
+        };
+
+        MatchingEngine(ClientResponseLFQueue *client_responses,
+                       MEMarketUpdateRing *market_updates,
+                       const InstrumentRegistry &instruments,
+                       const std::string &name,
+                       const std::string &log_file);
+
+        // Opens the book for the request's ticker, or answers/drops the request and returns nullptr.
+        auto openOrderBook(const MEClientRequest *client_request) noexcept -> MEOrderBook *;
+
+        auto releaseIdleOrderBooks() noexcept -> void;
+
+        // Called when a batch outgrows its reserved slots.
+        auto reserveResponses() noexcept -> void;
+
+        auto reserveMarketUpdates() noexcept -> void;
+
+        auto publishBatch() noexcept -> void;
+
+        const std::string name_;
+        const InstrumentRegistry instruments_;
+        std::vector<BookSlot> books_;
+        size_t num_open_books_ = 0;
+        Nanos last_release_check_time_ = 0;
+        size_t requests_since_release_check_ = 0;
+        MEClientResponse client_response_;
+
+        size_t batch_size_ = 0;
+        size_t pending_responses_ = 0;
+        size_t reserved_responses_ = 0;
+        size_t pending_market_updates_ = 0;
+        size_t reserved_market_updates_ = 0;
+        // Outputs of the current batch already published early because it outgrew the queue's free space.
+        size_t batch_responses_flushed_ = 0;
+        size_t batch_market_updates_flushed_ = 0;
 
         ClientRequestLFQueue *incoming_requests_ = nullptr;
+        ClientRequestMPSCQueue *incoming_gateway_requests_ = nullptr;
         ClientResponseLFQueue *outgoing_ogw_responses_ = nullptr;
-        MEMarketUpdateLFQueue *outgoing_md_updates_ = nullptr;
+        MEMarketUpdateRing *outgoing_md_updates_ = nullptr;
 
         volatile bool run_{false};
+        IdleStrategy idle_strategy_;
 
         std::string time_str_;
         Logger logger_;
+
+        LatencyHistogram *process_request_latency_ = nullptr;
+        LatencyHistogram *request_queue_depth_ = nullptr;
+        Counter *requests_processed_ = nullptr;
+        Counter *books_opened_ = nullptr;
+        Counter *books_released_ = nullptr;
+        Counter *unknown_ticker_requests_ = nullptr;
+        LatencyHistogram *batch_latency_ = nullptr;
+        LatencyHistogram *batch_responses_ = nullptr;
+        LatencyHistogram *batch_market_updates_ = nullptr;
     };
 }
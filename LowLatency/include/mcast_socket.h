@@ -5,39 +5,152 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
 #include "socket_utils.h"
 #include "logging.h"
+#include "io_uring.h"
+#include "xdp_socket.h"
+#include "metrics.h"
 
 
 namespace LL::Common {
-    constexpr size_t McastBufferSize{64 * 1024 * 1024};
+    // 1500 byte Ethernet MTU less the IPv4 and UDP headers, larger datagrams would be fragmented or dropped.
+    constexpr size_t McastMaxDatagramSize{1472};
+    constexpr size_t McastMaxDatagrams{1024};
+    constexpr size_t McastRecvBatch{64};
 
+    constexpr uint64_t McastIoUringRecv = 1;
+    constexpr uint64_t McastIoUringSend = 2;
+
+    // Datagram oriented multicast socket. Outgoing bytes are written into fixed size datagram slots, a write that
+    // does not fit the open datagram starts the next one, and sendAndRecv() pushes every finished datagram out with
+    // one sendmmsg(). Incoming datagrams are read in batches with recvmmsg() and appended back to back to
+    // inbound_data_, so every datagram has to be self-delimiting. The histograms are single writer, sockets driven
+    // from different threads need their own metrics_prefix.
     struct McastSocket {
-        McastSocket(Logger &logger): logger_(logger) {
-            outbound_data_.resize(McastBufferSize);
-            inbound_data_.resize(McastBufferSize);
+        explicit McastSocket(Logger &logger, size_t max_datagram_size = McastMaxDatagramSize,
+                             const std::string &metrics_prefix = "Common/McastSocket")
+            : max_datagram_size_(max_datagram_size), logger_(logger),
+              kernel_to_user_latency_(MetricsRegistry::instance().histogram(metrics_prefix + "/kernel_to_user_ns")),
+              send_to_wire_latency_(MetricsRegistry::instance().histogram(metrics_prefix + "/send_to_wire_ns")) {
+            outbound_data_.resize(McastMaxDatagrams * max_datagram_size_);
+            outbound_lens_.resize(McastMaxDatagrams + 1, 0);
+            inbound_data_.resize(McastMaxDatagrams * max_datagram_size_);
+
+            send_iovs_.resize(McastMaxDatagrams);
+            send_msgs_.resize(McastMaxDatagrams);
+            recv_iovs_.resize(McastRecvBatch);
+            recv_msgs_.resize(McastRecvBatch);
+            recv_ctrls_.resize(McastRecvBatch * TimestampCtrlSize);
+            tx_send_times_.resize(McastMaxDatagrams, 0);
         }
 
+        // Receive stamps are always on, tx_timestamps also loops a kernel transmit stamp back for every datagram
+        // sent and charts it against the time of the send call.
         auto init(const std::string &ip, const std::string &iface, int port,
-                  bool is_listening) -> int;
+                  bool is_listening, bool tx_timestamps = false) -> int;
 
         auto join(const std::string &ip) -> bool;
 
         auto leave(const std::string &ip, int port) -> void;
 
+        // Bytes left in the open datagram.
+        auto datagramSpace() const noexcept {
+            return max_datagram_size_ - outbound_lens_[num_datagrams_];
+        }
+
+        // Space for len bytes in a single datagram, starting a new one if the open datagram cannot take them.
+        auto reserve(size_t len) noexcept -> char * {
+            ASSERT(len <= max_datagram_size_, "McastSocket write:" + std::to_string(len) + " larger than a datagram.");
+            if (UNLIKELY(len > datagramSpace()))
+                endDatagram();
+            ASSERT(num_datagrams_ < McastMaxDatagrams, "McastSocket out of datagram slots.");
+            return outbound_data_.data() + num_datagrams_ * max_datagram_size_ + outbound_lens_[num_datagrams_];
+        }
+
+        auto commit(size_t len) noexcept {
+            outbound_lens_[num_datagrams_] += len;
+        }
+
+        auto endDatagram() noexcept -> void;
+
         auto send(const void *data, size_t len) noexcept -> void;
 
         auto sendAndRecv() noexcept -> bool;
 
+        // Switches this socket to io_uring after init(), datagrams arrive through a multishot receive and finished
+        // datagrams go out asynchronously, recv_callback_ and the buffers behave as before. Not combinable with
+        // enableXdp().
+        auto enableIoUring(unsigned ring_entries = IoUringDefaultEntries, bool sqpoll = false,
+                           int sqpoll_cpu = -1) -> void;
+
+        // Receives the flow this socket was init()ed for through AF_XDP on one NIC queue instead of the UDP stack,
+        // the kernel socket stays open for the group membership and for sending. Returns false, leaving the socket
+        // on the regular path, if AF_XDP cannot be set up or io_uring is already enabled.
+        auto enableXdp(const std::string &iface, int queue_id = 0) -> bool;
+
+        const size_t max_datagram_size_;
+
         std::vector<char> outbound_data_;
+        std::vector<size_t> outbound_lens_;
+        size_t num_datagrams_{0};
+        // Finished datagrams thrown away because a blocking flush hit a hard send error with every slot in use.
+        size_t dropped_datagrams_{0};
         std::vector<char> inbound_data_;
-        size_t next_send_valid_index_{0};
         size_t next_recv_valid_index_{0};
 
         int socket_fd_{-1};
-        std::function<void(McastSocket *s)> recv_callback_{nullptr};
+        // rx_time is the kernel receive stamp of the oldest datagram delivered in this call.
+        std::function<void(McastSocket *s, Nanos rx_time)> recv_callback_{nullptr};
+        // Optional, hands each datagram straight out of the receive slot, io_uring buffer or AF_XDP frame instead of
+        // copying it into inbound_data_ for recv_callback_. data is only valid during the call. rx_time is the
+        // datagram's own kernel stamp with recvmmsg(), the io_uring and AF_XDP paths only have the reap time.
+        std::function<void(McastSocket *s, const char *data, size_t len, Nanos rx_time)> recv_datagram_callback_{
+            nullptr
+        };
         Logger &logger_;
         std::string time_str_;
+
+        std::unique_ptr<IoUring> io_uring_;
+        std::unique_ptr<IoUringBufferPool> io_uring_buffers_;
+        size_t inflight_datagrams_ = 0;
+        size_t completed_datagrams_ = 0;
+
+        std::unique_ptr<XdpSocket> xdp_;
+
+    private:
+        auto sendDatagrams(bool block) noexcept -> void;
+
+        auto recvDatagrams() noexcept -> bool;
+
+        auto recvXdp() noexcept -> bool;
+
+        auto dropDatagrams(size_t n) noexcept -> void;
+
+        auto sendAndRecvIoUring() noexcept -> bool;
+
+        auto reapIoUring() noexcept -> bool;
+
+        auto recordTxSends(size_t n, Nanos send_time) noexcept -> void;
+
+        auto readTxTimestamps() noexcept -> void;
+
+        std::vector<iovec> send_iovs_;
+        std::vector<mmsghdr> send_msgs_;
+        std::vector<iovec> recv_iovs_;
+        std::vector<mmsghdr> recv_msgs_;
+        std::vector<char> recv_ctrls_;
+        Nanos rx_time_ = 0;
+
+        std::string ip_;
+        int port_ = -1;
+
+        bool tx_timestamps_ = false;
+        uint32_t tx_next_id_ = 0;
+        std::vector<Nanos> tx_send_times_;
+
+        LatencyHistogram *kernel_to_user_latency_ = nullptr;
+        LatencyHistogram *send_to_wire_latency_ = nullptr;
     };
 }
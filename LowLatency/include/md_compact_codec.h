@@ -0,0 +1,210 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <array>
+#include <bit>
+
+#include "market_update.h"
+
+namespace LL::Exchange {
+    // Upper bound of one encoded update: head and presence bytes, a 32 bit and four 64 bit varints.
+    constexpr size_t MDCompactMaxUpdateSize = 2 + 5 + 4 * 10;
+    // Tickers per packet that get price delta state, the prices of any further tickers are sent against 0.
+    constexpr size_t MDCompactMaxPacketTickers = 16;
+
+    inline auto zigZagEncode(int64_t value) noexcept {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline auto zigZagDecode(uint64_t value) noexcept {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    inline auto encodeVarint(char *dest, uint64_t value) noexcept {
+        size_t len = 0;
+        while (value >= 0x80) {
+            dest[len++] = static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        dest[len++] = static_cast<char>(value);
+        return len;
+    }
+
+    // Returns the number of bytes read, 0 if the varint is truncated or too long. With 8 readable bytes a varint of
+    // up to 8 bytes is found and unpacked with a handful of word operations instead of a per byte loop.
+    inline auto decodeVarint(const char *src, size_t len, uint64_t *value) noexcept -> size_t {
+        if (LIKELY(len >= sizeof(uint64_t))) {
+            uint64_t word;
+            memcpy(&word, src, sizeof(word));
+            const auto stops = ~word & 0x8080808080808080ULL;
+            if (LIKELY(stops)) {
+                const auto num_bytes = static_cast<size_t>(std::countr_zero(stops)) / 8 + 1;
+                auto x = (num_bytes < 8 ? word & ((1ULL << (8 * num_bytes)) - 1) : word) & 0x7f7f7f7f7f7f7f7fULL;
+                x = ((x & 0x7f007f007f007f00ULL) >> 1) | (x & 0x007f007f007f007fULL);
+                x = ((x & 0x3fff00003fff0000ULL) >> 2) | (x & 0x00003fff00003fffULL);
+                x = ((x & 0x0fffffff00000000ULL) >> 4) | (x & 0x000000000fffffffULL);
+                *value = x;
+                return num_bytes;
+            }
+        }
+
+        uint64_t result = 0;
+        for (size_t i = 0; i < len && i < 10; ++i) {
+            const auto byte = static_cast<uint8_t>(src[i]);
+            result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+            if (!(byte & 0x80)) {
+                *value = result;
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    // Compact encoding of one MEMarketUpdate. A head byte carries the type and side, a presence byte flags the fields
+    // that are set (INVALID fields are left out), followed by varints: the ticker, the order id as a zig-zag delta
+    // against the previous update in the packet, the price as a zig-zag delta against the previous price of the same
+    // ticker in the packet, the quantity and the priority. The sequence number is implied by the packet header. The
+    // state starts over with every packet so each datagram decodes on its own, and the last prices are kept only for
+    // the tickers seen in the packet, so encoder and decoder agree whatever the ticker ids are.
+    class MDCompactCodec final {
+    public:
+        enum Presence : uint8_t {
+            TICKER = 1 << 0,
+            ORDER_ID = 1 << 1,
+            PRICE = 1 << 2,
+            QUANTITY = 1 << 3,
+            PRIORITY = 1 << 4
+        };
+
+        auto reset() noexcept {
+            last_order_id_ = 0;
+            num_tickers_ = 0;
+        }
+
+        // dest must have MDCompactMaxUpdateSize bytes of room, returns the bytes written.
+        auto encode(char *dest, const MEMarketUpdate &update) noexcept {
+            uint8_t presence = 0;
+            size_t len = 2;
+            if (update.ticker_id_ != TickerId_INVALID) {
+                presence |= TICKER;
+                len += encodeVarint(dest + len, update.ticker_id_);
+            }
+            if (update.order_id_ != OrderId_INVALID) {
+                presence |= ORDER_ID;
+                len += encodeVarint(dest + len, zigZagEncode(static_cast<int64_t>(update.order_id_ - last_order_id_)));
+                last_order_id_ = update.order_id_;
+            }
+            if (update.price_ != Price_INVALID) {
+                presence |= PRICE;
+                auto &last_price = lastPrice(update.ticker_id_);
+                len += encodeVarint(dest + len, zigZagEncode(update.price_ - last_price));
+                last_price = update.price_;
+            }
+            if (update.quantity_ != Quantity_INVALID) {
+                presence |= QUANTITY;
+                len += encodeVarint(dest + len, update.quantity_);
+            }
+            if (update.priority_ != Priority_INVALID) {
+                presence |= PRIORITY;
+                len += encodeVarint(dest + len, update.priority_);
+            }
+
+            dest[0] = static_cast<char>(static_cast<uint8_t>(update.type_) | (sideToCode(update.side_) << 3));
+            dest[1] = static_cast<char>(presence);
+            return len;
+        }
+
+        // Returns the bytes read, 0 if the record is malformed or truncated.
+        auto decode(const char *src, size_t len, MEMarketUpdate *update) noexcept -> size_t {
+            if (UNLIKELY(len < 2))
+                return 0;
+            const auto head = static_cast<uint8_t>(src[0]);
+            const auto presence = static_cast<uint8_t>(src[1]);
+            *update = {};
+            update->type_ = static_cast<MarketUpdateType>(head & 0x7);
+            update->side_ = codeToSide((head >> 3) & 0x3);
+
+            size_t offset = 2;
+            uint64_t value = 0;
+            auto next = [&]() {
+                const auto n = decodeVarint(src + offset, len - offset, &value);
+                offset += n;
+                return n != 0;
+            };
+
+            if (presence & TICKER) {
+                if (UNLIKELY(!next()))
+                    return 0;
+                update->ticker_id_ = static_cast<TickerId>(value);
+            }
+            if (presence & ORDER_ID) {
+                if (UNLIKELY(!next()))
+                    return 0;
+                last_order_id_ += static_cast<OrderId>(zigZagDecode(value));
+                update->order_id_ = last_order_id_;
+            }
+            if (presence & PRICE) {
+                if (UNLIKELY(!next()))
+                    return 0;
+                auto &last_price = lastPrice(update->ticker_id_);
+                last_price += zigZagDecode(value);
+                update->price_ = last_price;
+            }
+            if (presence & QUANTITY) {
+                if (UNLIKELY(!next()))
+                    return 0;
+                update->quantity_ = value;
+            }
+            if (presence & PRIORITY) {
+                if (UNLIKELY(!next()))
+                    return 0;
+                update->priority_ = value;
+            }
+            return offset;
+        }
+
+    private:
+        // The price delta state of ticker_id in this packet, added on first use while there is room.
+        auto lastPrice(TickerId ticker_id) noexcept -> Price & {
+            for (size_t i = 0; i < num_tickers_; ++i) {
+                if (tickers_[i] == ticker_id)
+                    return last_prices_[i];
+            }
+            if (UNLIKELY(num_tickers_ == MDCompactMaxPacketTickers)) {
+                untracked_price_ = 0;
+                return untracked_price_;
+            }
+            tickers_[num_tickers_] = ticker_id;
+            last_prices_[num_tickers_] = 0;
+            return last_prices_[num_tickers_++];
+        }
+
+        static constexpr auto sideToCode(Side side) noexcept -> uint8_t {
+            switch (side) {
+                case Side::BUY:
+                    return 1;
+                case Side::SELL:
+                    return 2;
+                case Side::MAX:
+                    return 3;
+                case Side::INVALID:
+                    return 0;
+            }
+            return 0;
+        }
+
+        static constexpr auto codeToSide(uint8_t code) noexcept -> Side {
+            constexpr std::array<Side, 4> sides{Side::INVALID, Side::BUY, Side::SELL, Side::MAX};
+            return sides[code];
+        }
+
+        OrderId last_order_id_ = 0;
+        std::array<TickerId, MDCompactMaxPacketTickers> tickers_{};
+        std::array<Price, MDCompactMaxPacketTickers> last_prices_{};
+        size_t num_tickers_ = 0;
+        Price untracked_price_ = 0;
+    };
+}
@@ -0,0 +1,111 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <array>
+#include <functional>
+
+#include "md_packetizer.h"
+#include "metrics.h"
+
+namespace LL::Exchange {
+    constexpr size_t MDArbiterWindow = 64 * 1024;
+    constexpr Nanos MDArbiterGapTimeout = 1000 * 1000;
+
+    enum class MDLine : uint8_t {
+        A = 0,
+        B = 1
+    };
+
+    inline std::string mdLineToString(MDLine line) {
+        switch (line) {
+            case MDLine::A:
+                return "A";
+            case MDLine::B:
+                return "B";
+        }
+        return "UNKNOWN";
+    }
+
+    struct MDLineStats {
+        Counter *updates_ = nullptr;
+        // Updates this line delivered first, and late copies of updates already forwarded from the other line.
+        Counter *firsts_ = nullptr;
+        Counter *duplicates_ = nullptr;
+        // Sequence numbers this line skipped, whether or not the other line filled them.
+        Counter *gaps_ = nullptr;
+        // How far this line trailed the other one on updates both delivered, by the receive stamps of the datagrams
+        // that carried them.
+        LatencyHistogram *lag_ = nullptr;
+    };
+
+    // Arbitrates the redundant A and B incremental feeds. Both sockets deliver the same packets, each sequence number
+    // is forwarded once, from whichever line has it first, and in order. Updates ahead of a gap are held in a window
+    // until the other line fills the gap; a gap neither line fills within the timeout is skipped and reported through
+    // gap_callback_ so the consumer can recover from the snapshot stream. The lines are read through their
+    // recv_datagram_callback_. The counters are single writer, arbiters on different threads need their own
+    // metrics_prefix.
+    class MDLineArbiter final {
+    public:
+        MDLineArbiter(McastSocket *line_a, McastSocket *line_b,
+                      std::function<void(const MDPMarketUpdate &update)> update_callback,
+                      Nanos gap_timeout = MDArbiterGapTimeout,
+                      const std::string &metrics_prefix = "Exchange/MDLineArbiter");
+
+        // Reads both lines and forwards what is in sequence.
+        auto sendAndRecv() noexcept -> bool;
+
+        auto nextSeqNum() const noexcept {
+            return next_seq_num_;
+        }
+
+        // Called with [first, last] when a gap is given up on.
+        std::function<void(size_t first_seq_num, size_t last_seq_num)> gap_callback_{nullptr};
+
+        MDLineArbiter() = delete;
+
+        MDLineArbiter(const MDLineArbiter &) = delete;
+
+        MDLineArbiter(const MDLineArbiter &&) = delete;
+
+        MDLineArbiter &operator=(const MDLineArbiter &) = delete;
+
+        MDLineArbiter &operator=(const MDLineArbiter &&) = delete;
+
+    private:
+        struct Slot {
+            size_t seq_num_ = 0;
+            Nanos rx_time_ = 0;
+            MDLine line_ = MDLine::A;
+            bool pending_ = false;
+            MEMarketUpdate update_;
+        };
+
+        auto onDatagram(MDLine line, const char *data, size_t len, Nanos rx_time) noexcept -> void;
+
+        auto onUpdate(MDLine line, const MDPMarketUpdate &update, Nanos rx_time) noexcept -> void;
+
+        auto forward(size_t seq_num, const MEMarketUpdate &update) noexcept -> void;
+
+        auto drainPending() noexcept -> void;
+
+        auto skipGap() noexcept -> void;
+
+        std::array<McastSocket *, 2> lines_;
+        std::function<void(const MDPMarketUpdate &update)> update_callback_;
+        const Nanos gap_timeout_;
+
+        size_t next_seq_num_ = 0;
+        std::array<size_t, 2> line_next_seq_num_{};
+        // Indexed by seq_num % MDArbiterWindow, keeps the first arrival of recent sequence numbers for the lag
+        // statistics and holds updates that arrived ahead of a gap.
+        std::vector<Slot> window_;
+        size_t num_pending_ = 0;
+        Nanos gap_start_time_ = 0;
+
+        std::array<MDLineStats, 2> stats_;
+        Counter *skipped_ = nullptr;
+    };
+}
@@ -0,0 +1,118 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include "mcast_socket.h"
+#include "market_update.h"
+#include "md_compact_codec.h"
+
+namespace LL::Exchange {
+    // Packs sequenced market updates into MTU-sized datagrams on a McastSocket. Each datagram starts with an
+    // MDPacketHeader whose count and length are bumped in place as updates are appended, a new datagram is started
+    // once the next update might not fit.
+    class MDPacketizer final {
+    public:
+        explicit MDPacketizer(McastSocket *socket, MDPacketFormat format = MDPacketFormat::RAW)
+            : socket_(socket), format_(format) {
+            ASSERT(socket_->max_datagram_size_ >= sizeof(MDPacketHeader) + maxUpdateSize(),
+                   "Datagram size too small for a market data packet:" + std::to_string(socket_->max_datagram_size_));
+        }
+
+        auto add(size_t seq_num, const MEMarketUpdate &market_update) noexcept {
+            if (!header_ || socket_->datagramSpace() < maxUpdateSize()) {
+                socket_->endDatagram();
+                header_ = reinterpret_cast<MDPacketHeader *>(socket_->reserve(sizeof(MDPacketHeader)));
+                *header_ = {seq_num, 0, 0, format_};
+                socket_->commit(sizeof(MDPacketHeader));
+                codec_.reset();
+            }
+
+            size_t len = sizeof(MDPMarketUpdate);
+            if (format_ == MDPacketFormat::COMPACT) {
+                len = codec_.encode(socket_->reserve(MDCompactMaxUpdateSize), market_update);
+            } else {
+                auto update = reinterpret_cast<MDPMarketUpdate *>(socket_->reserve(sizeof(MDPMarketUpdate)));
+                *update = {seq_num, market_update};
+            }
+            socket_->commit(len);
+            ++header_->num_updates_;
+            header_->length_ += static_cast<uint16_t>(len);
+        }
+
+        // Closes the open datagram so it goes out with the next sendAndRecv().
+        auto flush() noexcept {
+            if (header_) {
+                socket_->endDatagram();
+                header_ = nullptr;
+            }
+        }
+
+        // Switches the encoding from the next datagram on.
+        auto setFormat(MDPacketFormat format) noexcept {
+            flush();
+            format_ = format;
+        }
+
+        MDPacketizer() = delete;
+
+        MDPacketizer(const MDPacketizer &) = delete;
+
+        MDPacketizer(const MDPacketizer &&) = delete;
+
+        MDPacketizer &operator=(const MDPacketizer &) = delete;
+
+        MDPacketizer &operator=(const MDPacketizer &&) = delete;
+
+    private:
+        auto maxUpdateSize() const noexcept -> size_t {
+            return format_ == MDPacketFormat::COMPACT ? MDCompactMaxUpdateSize : sizeof(MDPMarketUpdate);
+        }
+
+        McastSocket *socket_ = nullptr;
+        MDPacketFormat format_ = MDPacketFormat::RAW;
+        MDPacketHeader *header_ = nullptr;
+        MDCompactCodec codec_;
+    };
+
+    // Walks the complete packets at the front of data, calling func(const MDPMarketUpdate &) per update in either
+    // format, and returns the number of bytes consumed. A trailing partial packet is left for the next call, the
+    // rest of a malformed compact packet is dropped.
+    template<typename F>
+    inline auto parseMDPackets(const char *data, size_t len, F &&func) noexcept {
+        size_t offset = 0;
+        MDCompactCodec codec;
+        while (len - offset >= sizeof(MDPacketHeader)) {
+            MDPacketHeader header;
+            memcpy(&header, data + offset, sizeof(header));
+            const auto packet_len = sizeof(MDPacketHeader) + header.length_;
+            if (len - offset < packet_len)
+                break;
+
+            const auto payload = data + offset + sizeof(MDPacketHeader);
+            MDPMarketUpdate update;
+            if (header.format_ == MDPacketFormat::COMPACT) {
+                codec.reset();
+                size_t payload_offset = 0;
+                for (size_t i = 0; i < header.num_updates_; ++i) {
+                    const auto n = codec.decode(payload + payload_offset, header.length_ - payload_offset,
+                                                &update.me_market_update_);
+                    if (UNLIKELY(!n))
+                        break;
+                    payload_offset += n;
+                    update.seq_num_ = header.first_seq_num_ + i;
+                    func(update);
+                }
+            } else if (header.format_ == MDPacketFormat::RAW) {
+                const auto num_updates = std::min<size_t>(header.num_updates_, header.length_ / sizeof(MDPMarketUpdate));
+                for (size_t i = 0; i < num_updates; ++i) {
+                    memcpy(&update, payload + i * sizeof(MDPMarketUpdate), sizeof(update));
+                    func(update);
+                }
+            }
+            offset += packet_len;
+        }
+        return offset;
+    }
+}
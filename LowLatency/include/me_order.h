@@ -8,52 +8,61 @@
 #include <sstream>
 #include <array>
 #include "types.h"
+#include "client_order_map.h"
 
 
 using namespace LL::Common;
 
 namespace LL::Exchange {
-    struct MEOrder {
-        TickerId ticker_id_ = TickerId_INVALID;
-        ClientId client_id_ = ClientId_INVALID;
+    // The part of a resting order that matching reads and writes, packed two to a cache line. A level keeps its
+    // orders in a contiguous array of these in time priority, so a sweep through several orders is a linear scan. A
+    // zero quantity marks a canceled order that the level has not compacted away yet.
+    struct MEOrderRecord {
         OrderId client_order_id_ = OrderId_INVALID;
         OrderId market_order_id_ = OrderId_INVALID;
+        Quantity quantity_ = 0;
+        ClientId client_id_ = ClientId_INVALID;
+    };
+
+    static_assert(sizeof(MEOrderRecord) == 32, "MEOrderRecord should stay at half a cache line.");
+
+    // The cold part of a resting order, reached through the client order map on cancels. slot_ is the index of its
+    // MEOrderRecord in the level's array.
+    struct MEOrder {
+        TickerId ticker_id_ = TickerId_INVALID;
         Side side_ = Side::INVALID;
         Price price_ = Price_INVALID;
-        Quantity quantity_ = Quantity_INVALID;
         Priority priority_ = Priority_INVALID;
-
-        MEOrder *prev_order_ = nullptr;
-        MEOrder *next_order_ = nullptr;
+        uint32_t slot_ = 0;
 
         MEOrder() = default;
 
-        MEOrder(TickerId ticker_id, ClientId client_id, OrderId client_order_id, OrderId market_order_id, Side side,
-                Price price, Quantity quantity, Priority priority, MEOrder *prev_order, MEOrder *next_order) noexcept
-            : ticker_id_(ticker_id), client_id_(client_id), client_order_id_(client_order_id),
-              market_order_id_(market_order_id), side_(side), price_(price), quantity_(quantity),
-              priority_(priority), prev_order_(prev_order), next_order_(next_order) {
+        MEOrder(TickerId ticker_id, Side side, Price price, Priority priority, uint32_t slot) noexcept
+            : ticker_id_(ticker_id), side_(side), price_(price), priority_(priority), slot_(slot) {
         }
 
         auto toString() const noexcept -> std::string;
     };
 
-    using OrderHashMap = std::array<MEOrder *, ME_MAX_ORDER_IDS>;
-    using ClientOrderHashMap = std::array<OrderHashMap, ME_MAX_NUM_CLIENTS>;
+    using ClientOrderHashMap = ClientOrderMap<MEOrder>;
 
+    // One price level, ordered among the others by MEPriceLadder. Its orders are orders_[head_, tail_) in time
+    // priority, num_orders_ of them still live.
     struct MEOrdersAtPrice {
         Side side_ = Side::INVALID;
         Price price_ = Price_INVALID;
-        MEOrder *first_me_order_ = nullptr;
-        MEOrdersAtPrice *prev_entry_ = nullptr;
-        MEOrdersAtPrice *next_entry_ = nullptr;
+
+        MEOrderRecord *orders_ = nullptr;
+        uint32_t capacity_ = 0;
+        uint32_t head_ = 0;
+        uint32_t tail_ = 0;
+        uint32_t num_orders_ = 0;
+        Priority next_priority_ = 1;
 
         MEOrdersAtPrice() = default;
 
-        MEOrdersAtPrice(Side side, Price price, MEOrder *first_me_order, MEOrdersAtPrice *prev_entry,
-                        MEOrdersAtPrice *next_entry) noexcept
-            : side_(side), price_(price), first_me_order_(first_me_order), prev_entry_(prev_entry),
-              next_entry_(next_entry) {
+        MEOrdersAtPrice(Side side, Price price) noexcept
+            : side_(side), price_(price) {
         }
 
         auto toString() const {
@@ -61,13 +70,10 @@ namespace LL::Exchange {
             ss << "MEOrdersAtPrice["
                     << "side:" << sideToString(side_) << " "
                     << "price:" << priceToString(price_) << " "
-                    << "first_me_order:" << (first_me_order_ ? first_me_order_->toString() : "null") << " "
-                    << "prev:" << priceToString(prev_entry_ ? prev_entry_->price_ : Price_INVALID) << " "
-                    << "next:" << priceToString(next_entry_ ? next_entry_->price_ : Price_INVALID) << "]";
+                    << "orders:" << num_orders_ << " "
+                    << "slots:" << head_ << "-" << tail_ << "/" << capacity_ << "]";
 
             return ss.str();
         }
     };
-
-    using OrdersAtPriceHashMap = std::array<MEOrdersAtPrice *, ME_MAX_PRICE_LEVELS>;
 }
@@ -0,0 +1,121 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include <sys/mman.h>
+
+#include "macros.h"
+#include "mem_pool.h"
+#include "me_order.h"
+#include "instrument_registry.h"
+
+namespace LL::Exchange {
+    // Power of two sized blocks of MEOrderRecord for the per level order queues, carved out of one mapping sized from
+    // the instrument when the book is built. Released blocks go on a free list per size, kept inside the blocks
+    // themselves, and are handed out again, so neither growing nor emptying a level touches the heap. Blocks are
+    // never returned to the mapping, running out of it is fatal like running out of orders.
+    class MEOrderBlockPool final {
+    public:
+        static constexpr uint32_t MinBlockSize = 16;
+
+        // Room for a minimum block on every level plus grown blocks holding twice the instrument's max orders.
+        explicit MEOrderBlockPool(const InstrumentCfg &instrument)
+            : num_records_(MinBlockSize * (instrument.max_price_levels_ + 1) + 2 * instrument.max_orders_) {
+            mapStore();
+        }
+
+        ~MEOrderBlockPool() {
+            munmap(store_, mapped_size_);
+            store_ = nullptr;
+        }
+
+        // Rounds capacity up to the block size actually handed out.
+        static constexpr auto blockSize(uint32_t capacity) noexcept -> uint32_t {
+            return std::bit_ceil(std::max(capacity, MinBlockSize));
+        }
+
+        auto allocate(uint32_t capacity) noexcept -> MEOrderRecord * {
+            auto &free_head = free_blocks_[sizeClass(capacity)];
+            if (LIKELY(free_head)) {
+                const auto block = free_head;
+                memcpy(&free_head, block, sizeof(free_head));
+                return block;
+            }
+
+            const auto block_size = blockSize(capacity);
+            if (UNLIKELY(num_carved_ + block_size > num_records_))
+                FATAL("MEOrderBlockPool out of records for a block of " + std::to_string(block_size) +
+                      ", carved:" + std::to_string(num_carved_) + " of " + std::to_string(num_records_));
+            const auto block = store_ + num_carved_;
+            num_carved_ += block_size;
+            return block;
+        }
+
+        auto release(MEOrderRecord *block, uint32_t capacity) noexcept -> void {
+            auto &free_head = free_blocks_[sizeClass(capacity)];
+            memcpy(block, &free_head, sizeof(free_head));
+            free_head = block;
+        }
+
+        auto capacity() const noexcept {
+            return num_records_;
+        }
+
+        // Records handed out at least once, in use or on a free list.
+        auto carved() const noexcept {
+            return num_carved_;
+        }
+
+        MEOrderBlockPool() = delete;
+
+        MEOrderBlockPool(const MEOrderBlockPool &) = delete;
+
+        MEOrderBlockPool(const MEOrderBlockPool &&) = delete;
+
+        MEOrderBlockPool &operator=(const MEOrderBlockPool &) = delete;
+
+        MEOrderBlockPool &operator=(const MEOrderBlockPool &&) = delete;
+
+    private:
+        static constexpr auto sizeClass(uint32_t capacity) noexcept -> size_t {
+            return std::countr_zero(blockSize(capacity));
+        }
+
+        // Same as MemPool: reserved 2 MB pages for a store of at least one, otherwise regular pages advised as
+        // transparent hugepages before they are prefaulted. Blocks are multiples of 512 bytes carved from a page
+        // aligned start, so every block is cache line aligned.
+        auto mapStore() noexcept -> void {
+            const auto size = num_records_ * sizeof(MEOrderRecord);
+            void *mem = MAP_FAILED;
+
+            if (size >= HUGE_PAGE_SIZE) {
+                mapped_size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+                mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            }
+
+            if (mem == MAP_FAILED) {
+                mapped_size_ = size;
+                mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                ASSERT(mem != MAP_FAILED, "mmap() failed for MEOrderBlockPool. errno:" + std::string(strerror(errno)));
+                if (size >= HUGE_PAGE_SIZE)
+                    madvise(mem, mapped_size_, MADV_HUGEPAGE);
+                memset(mem, 0, mapped_size_);
+            }
+
+            store_ = static_cast<MEOrderRecord *>(mem);
+        }
+
+        const size_t num_records_;
+        MEOrderRecord *store_ = nullptr;
+        size_t mapped_size_ = 0;
+        size_t num_carved_ = 0;
+        std::array<MEOrderRecord *, 32> free_blocks_{};
+    };
+}
@@ -11,7 +11,10 @@
 #include "client_response.h"
 #include "market_update.h"
 
+#include "instrument_registry.h"
 #include "me_order.h"
+#include "me_order_block_pool.h"
+#include "me_price_ladder.h"
 
 using namespace LL::Common;
 
@@ -20,9 +23,12 @@ namespace LL::Exchange {
 
     class MEOrderBook final {
     public:
-        explicit MEOrderBook(TickerId ticker_id,
-                             Logger *logger,
-                             MatchingEngine *matching_engine);
+        // Pools are sized from instrument. next_market_order_id continues the ids of an earlier book for the same
+        // ticker so they stay unique across a release and reopen.
+        MEOrderBook(const InstrumentCfg &instrument,
+                    Logger *logger,
+                    MatchingEngine *matching_engine,
+                    OrderId next_market_order_id = 1);
 
         ~MEOrderBook();
 
@@ -36,6 +42,15 @@ namespace LL::Exchange {
         auto toString(bool detailed,
                       bool validity_check) const -> std::string;
 
+        // No resting orders.
+        auto empty() const noexcept {
+            return !cid_oid_to_order_.size();
+        }
+
+        auto nextMarketOrderId() const noexcept {
+            return next_market_order_id_;
+        }
+
         MEOrderBook() = delete;
 
         MEOrderBook(const MEOrderBook &) = delete;
@@ -51,10 +66,8 @@ namespace LL::Exchange {
         MatchingEngine *matching_engine_ = nullptr;
         ClientOrderHashMap cid_oid_to_order_;
         MemPool<MEOrdersAtPrice> orders_at_price_pool_;
-        MEOrdersAtPrice *bids_by_price_ = nullptr;
-        MEOrdersAtPrice *asks_by_price_ = nullptr;
-
-        OrdersAtPriceHashMap price_orders_at_price_;
+        MEPriceLadder price_ladder_;
+        MEOrderBlockPool order_block_pool_;
         MemPool<MEOrder> order_pool_;
 
         MEClientResponse client_response_;
@@ -70,146 +83,92 @@ namespace LL::Exchange {
             return next_market_order_id_++;
         }
 
-        auto priceToIndex(Price price) const noexcept {
-            return price % ME_MAX_PRICE_LEVELS;
-        }
-
         auto getOrdersAtPrice(Price price) const noexcept -> MEOrdersAtPrice * {
-            return price_orders_at_price_.at(priceToIndex(price));
+            return price_ladder_.get(price);
         }
 
-
-        auto addOrdersAtPrice(MEOrdersAtPrice *new_orders_at_price) noexcept {
-            price_orders_at_price_.at(priceToIndex(new_orders_at_price->price_)) = new_orders_at_price;
-
-            const auto best_orders_by_price = (
-                new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_);
-            if (UNLIKELY(!best_orders_by_price)) {
-                (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_) = new_orders_at_price;
-                new_orders_at_price->prev_entry_ = new_orders_at_price->next_entry_ = new_orders_at_price;
-            } else {
-                auto target = best_orders_by_price;
-                bool add_after = ((new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ > target->
-                                   price_)
-                                  || (new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ < target->
-                                      price_));
-
-                if (add_after) {
-                    target = target->next_entry_;
-                    add_after = ((new_orders_at_price->side_ == Side::SELL &&
-                                  new_orders_at_price->price_ > target->price_) ||
-                                 (new_orders_at_price->side_ == Side::BUY &&
-                                  new_orders_at_price->price_ < target->price_));
-                }
-
-                while (add_after && target != best_orders_by_price) {
-                    add_after = ((new_orders_at_price->side_ == Side::SELL &&
-                                  new_orders_at_price->price_ > target->price_) ||
-                                 (new_orders_at_price->side_ == Side::BUY &&
-                                  new_orders_at_price->price_ < target->price_));
-                    if (add_after)
-                        target = target->next_entry_;
-                }
-
-                if (add_after) {
-                    if (target == best_orders_by_price) {
-                        target = best_orders_by_price->prev_entry_;
-                    }
-
-                    new_orders_at_price->prev_entry_ = target;
-                    target->next_entry_->prev_entry_ = new_orders_at_price;
-                    new_orders_at_price->next_entry_ = target->next_entry_;
-                    target->next_entry_ = new_orders_at_price;
-                } else {
-                    new_orders_at_price->prev_entry_ = target->prev_entry_;
-                    new_orders_at_price->next_entry_ = target;
-                    target->prev_entry_->next_entry_ = new_orders_at_price;
-                    target->prev_entry_ = new_orders_at_price;
-
-                    if ((new_orders_at_price->side_ == Side::BUY && new_orders_at_price->price_ > best_orders_by_price
-                         ->price_) ||
-                        (new_orders_at_price->side_ == Side::SELL && new_orders_at_price->price_ < best_orders_by_price
-                         ->
-                         price_)) {
-                        target->next_entry_ = (target->next_entry_ == best_orders_by_price
-                                                   ? new_orders_at_price
-                                                   : target->next_entry_);
-                        (new_orders_at_price->side_ == Side::BUY ? bids_by_price_ : asks_by_price_) =
-                                new_orders_at_price;
-                    }
-                }
-            }
+        auto recordOf(const MEOrder *order) const noexcept -> MEOrderRecord & {
+            return getOrdersAtPrice(order->price_)->orders_[order->slot_];
         }
 
-        auto removeOrdersAtPrice(Side side, Price price) noexcept {
-            const auto best_orders_by_price = (side == Side::BUY ? bids_by_price_ : asks_by_price_);
+        auto addOrder(TickerId ticker_id, Side side, Price price, const MEOrderRecord &record) noexcept -> Priority {
             auto orders_at_price = getOrdersAtPrice(price);
+            if (!orders_at_price) {
+                orders_at_price = orders_at_price_pool_.allocate(side, price);
+                price_ladder_.insert(orders_at_price);
+            }
 
-            if (UNLIKELY(orders_at_price->next_entry_ == orders_at_price)) {
-                (side == Side::BUY ? bids_by_price_ : asks_by_price_) = nullptr;
-            } else {
-                orders_at_price->prev_entry_->next_entry_ = orders_at_price->next_entry_;
-                orders_at_price->next_entry_->prev_entry_ = orders_at_price->prev_entry_;
+            if (UNLIKELY(orders_at_price->tail_ == orders_at_price->capacity_))
+                compactOrders(orders_at_price);
 
-                if (orders_at_price == best_orders_by_price) {
-                    (side == Side::BUY ? bids_by_price_ : asks_by_price_) = orders_at_price->next_entry_;
-                }
-                orders_at_price->prev_entry_ = orders_at_price->next_entry_ = nullptr;
-            }
+            const auto slot = orders_at_price->tail_++;
+            orders_at_price->orders_[slot] = record;
+            ++orders_at_price->num_orders_;
 
-            price_orders_at_price_.at(priceToIndex(price)) = nullptr;
-            orders_at_price_pool_.deallocate(orders_at_price);
+            const auto priority = orders_at_price->next_priority_++;
+            cid_oid_to_order_.insert(record.client_id_, record.client_order_id_,
+                                     order_pool_.allocate(ticker_id, side, price, priority, slot));
+            return priority;
         }
 
-        auto addOrder(MEOrder *order) noexcept {
+        auto removeOrder(MEOrder *order) noexcept {
             const auto orders_at_price = getOrdersAtPrice(order->price_);
+            auto &record = orders_at_price->orders_[order->slot_];
+            cid_oid_to_order_.erase(record.client_id_, record.client_order_id_);
+            order_pool_.deallocate(order);
 
-            if (!orders_at_price) {
-                order->next_order_ = order->prev_order_ = order;
-
-                auto new_orders_at_price = orders_at_price_pool_.allocate(order->side_,
-                                                                          order->price_, order, nullptr, nullptr);
-                addOrdersAtPrice(new_orders_at_price);
-            } else {
-                auto first_order = (orders_at_price ? orders_at_price->first_me_order_ : nullptr);
-
-                first_order->prev_order_->next_order_ = order;
-                order->prev_order_ = first_order->prev_order_;
-                order->next_order_ = first_order;
-                first_order->prev_order_ = order;
+            record.quantity_ = 0;
+            --orders_at_price->num_orders_;
+            trimOrders(orders_at_price);
+        }
+
+        // Drops canceled records off both ends of the level, or the level itself once its last order is gone.
+        auto trimOrders(MEOrdersAtPrice *orders_at_price) noexcept -> void {
+            if (!orders_at_price->num_orders_) {
+                price_ladder_.erase(orders_at_price);
+                if (orders_at_price->orders_)
+                    order_block_pool_.release(orders_at_price->orders_, orders_at_price->capacity_);
+                orders_at_price_pool_.deallocate(orders_at_price);
+                return;
             }
 
-            cid_oid_to_order_.at(order->client_id_).at(order->client_order_id_) = order;
+            const auto orders = orders_at_price->orders_;
+            while (!orders[orders_at_price->head_].quantity_)
+                ++orders_at_price->head_;
+            while (!orders[orders_at_price->tail_ - 1].quantity_)
+                --orders_at_price->tail_;
         }
 
-        auto removeOrder(MEOrder *order) noexcept {
-            const auto orders_at_price = getOrdersAtPrice(order->price_);
-            if (order->prev_order_ == order) {
-                removeOrdersAtPrice(order->side_, order->price_);
-            } else {
-                const auto order_before = order->prev_order_;
-                const auto order_after = order->next_order_;
-                order_before->next_order_ = order_after;
-                order_after->prev_order_ = order_before;
-
+        // Called when the level has no free slot at the tail. Moves the live records to the front of the array, into a
+        // block twice the size if more than half of the current one is live, and repoints their MEOrder slots.
+        auto compactOrders(MEOrdersAtPrice *orders_at_price) noexcept -> void {
+            const auto old_orders = orders_at_price->orders_;
+            const auto old_capacity = orders_at_price->capacity_;
+            const auto grow = !old_orders || orders_at_price->num_orders_ * 2 > old_capacity;
+
+            auto orders = old_orders;
+            if (grow) {
+                orders_at_price->capacity_ = MEOrderBlockPool::blockSize(old_capacity * 2);
+                orders = order_block_pool_.allocate(orders_at_price->capacity_);
+            }
 
-                if (orders_at_price->first_me_order_ == order) {
-                    orders_at_price->first_me_order_ = order_after;
+            uint32_t slot = 0;
+            for (auto i = orders_at_price->head_; i < orders_at_price->tail_; ++i) {
+                const auto &record = old_orders[i];
+                if (!record.quantity_)
+                    continue;
+                if (slot != i || orders != old_orders) {
+                    cid_oid_to_order_.find(record.client_id_, record.client_order_id_)->slot_ = slot;
+                    orders[slot] = record;
                 }
-
-                order->prev_order_ = order->next_order_ = nullptr;
+                ++slot;
             }
+            orders_at_price->orders_ = orders;
+            orders_at_price->head_ = 0;
+            orders_at_price->tail_ = slot;
 
-
-            cid_oid_to_order_.at(order->client_id_).at(order->client_order_id_) = nullptr;
-            order_pool_.deallocate(order);
-        }
-
-        auto getNextPriority(Price price) noexcept {
-            const auto orders_at_price = getOrdersAtPrice(price);
-            if (!orders_at_price)
-                return 1lu;
-            return orders_at_price->first_me_order_->prev_order_->priority_ + 1;
+            if (grow && old_orders)
+                order_block_pool_.release(old_orders, old_capacity);
         }
 
         auto match(TickerId ticker_id,
@@ -217,8 +176,8 @@ namespace LL::Exchange {
                    Side side,
                    OrderId client_order_id,
                    OrderId new_market_order_id,
-                   MEOrder *bid_itr,
-                   Quantity *leaves_qty) noexcept;
+                   MEOrdersAtPrice *orders_at_price,
+                   Quantity *leaves_qty) noexcept -> void;
 
         auto checkForMatch(ClientId client_id,
                            OrderId client_order_id,
@@ -226,8 +185,6 @@ namespace LL::Exchange {
                            Side side,
                            Price price,
                            Quantity qty,
-                           Quantity new_market_order_id) noexcept;
+                           Quantity new_market_order_id) noexcept -> Quantity;
     };
-
-    using OrderBookHashMap = std::array<MEOrderBook *, ME_MAX_TICKERS>;
 }
@@ -0,0 +1,221 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "level_bitmap.h"
+#include "me_order.h"
+
+namespace LL::Exchange {
+    // Price levels of one book, bids and asks, in a dense window of num_levels ticks starting at base_price_. A level
+    // is found by direct index, each side keeps an occupancy bitmap so the best level and the next level behind any
+    // level are bitmap scans rather than list walks. A price outside the window recenters it on the live levels when
+    // they fit, which costs a scan of the bitmaps and one move per live level, O(live levels) rather than O(1), but
+    // is rare once the window is wide enough for the instrument's trading range. Levels that still would not fit
+    // are kept per side in a price ordered overflow array, O(overflow levels) to insert or erase, which stays empty
+    // in normal trading. All storage is sized up front, max_levels being the most levels the book can hold, so
+    // neither path allocates.
+    class MEPriceLadder final {
+    public:
+        explicit MEPriceLadder(size_t num_levels = ME_PRICE_LADDER_LEVELS, size_t max_levels = ME_MAX_PRICE_LEVELS)
+            : num_levels_(num_levels), levels_(num_levels, nullptr),
+              bits_{LevelBitmap(num_levels), LevelBitmap(num_levels)} {
+            recenter_levels_.reserve(std::min(num_levels, max_levels));
+            for (auto &far: far_levels_)
+                far.reserve(max_levels);
+        }
+
+        auto get(Price price) const noexcept -> MEOrdersAtPrice * {
+            if (LIKELY(inWindow(price)))
+                return levels_[price - base_price_];
+            if (LIKELY(!num_far_levels_))
+                return nullptr;
+            for (const auto &far: far_levels_) {
+                if (const auto itr = farLowerBound(far, price); itr != far.end() && (*itr)->price_ == price)
+                    return *itr;
+            }
+            return nullptr;
+        }
+
+        auto best(Side side) const noexcept {
+            return best_[sideIndex(side)];
+        }
+
+        auto insert(MEOrdersAtPrice *level) noexcept -> void {
+            const auto s = sideIndex(level->side_);
+            const auto price = level->price_;
+            if (LIKELY(inWindow(price)) || recenter(price)) {
+                levels_[price - base_price_] = level;
+                bits_[s].set(price - base_price_);
+            } else {
+                auto &far = far_levels_[s];
+                if (UNLIKELY(far.size() == far.capacity()))
+                    FATAL("MEPriceLadder overflow levels full at price:" + priceToString(price));
+                far.insert(farLowerBound(far, price), level);
+                ++num_far_levels_;
+            }
+
+            if (!best_[s] || isBetter(level->side_, price, best_[s]->price_))
+                best_[s] = level;
+        }
+
+        auto erase(MEOrdersAtPrice *level) noexcept -> void {
+            const auto s = sideIndex(level->side_);
+            const auto price = level->price_;
+            if (LIKELY(inWindow(price))) {
+                levels_[price - base_price_] = nullptr;
+                bits_[s].clear(price - base_price_);
+            } else {
+                auto &far = far_levels_[s];
+                far.erase(farLowerBound(far, price));
+                --num_far_levels_;
+            }
+
+            if (best_[s] == level)
+                best_[s] = findBest(level->side_);
+        }
+
+        // The level after price in priority order on this side, i.e. the next lower bid or the next higher ask.
+        auto next(Side side, Price price) const noexcept -> MEOrdersAtPrice * {
+            const auto s = sideIndex(side);
+            MEOrdersAtPrice *window_level = nullptr;
+            MEOrdersAtPrice *far_level = nullptr;
+            if (side == Side::BUY) {
+                if (price > base_price_) {
+                    const auto i = bits_[s].findLastAtOrBelow(
+                        static_cast<size_t>(std::min<Price>(price - base_price_ - 1, num_levels_ - 1)));
+                    window_level = i == LevelBitmap::npos ? nullptr : levels_[i];
+                }
+                if (UNLIKELY(num_far_levels_)) {
+                    const auto itr = farLowerBound(far_levels_[s], price);
+                    far_level = itr == far_levels_[s].begin() ? nullptr : *std::prev(itr);
+                }
+            } else {
+                if (price < base_price_ + static_cast<Price>(num_levels_) - 1) {
+                    const auto i = bits_[s].findFirstAtOrAbove(
+                        static_cast<size_t>(std::max<Price>(price - base_price_ + 1, 0)));
+                    window_level = i == LevelBitmap::npos ? nullptr : levels_[i];
+                }
+                if (UNLIKELY(num_far_levels_)) {
+                    const auto itr = farLowerBound(far_levels_[s], price + 1);
+                    far_level = itr == far_levels_[s].end() ? nullptr : *itr;
+                }
+            }
+
+            return better(side, window_level, far_level);
+        }
+
+        auto basePrice() const noexcept {
+            return base_price_;
+        }
+
+        auto numFarLevels() const noexcept {
+            return num_far_levels_;
+        }
+
+        MEPriceLadder(const MEPriceLadder &) = delete;
+
+        MEPriceLadder(const MEPriceLadder &&) = delete;
+
+        MEPriceLadder &operator=(const MEPriceLadder &) = delete;
+
+        MEPriceLadder &operator=(const MEPriceLadder &&) = delete;
+
+    private:
+        static constexpr auto sideIndex(Side side) noexcept -> size_t {
+            return side == Side::BUY ? 0 : 1;
+        }
+
+        static constexpr auto isBetter(Side side, Price price, Price than) noexcept -> bool {
+            return side == Side::BUY ? price > than : price < than;
+        }
+
+        static constexpr auto better(Side side, MEOrdersAtPrice *a, MEOrdersAtPrice *b) noexcept -> MEOrdersAtPrice * {
+            if (!a || !b)
+                return a ? a : b;
+            return isBetter(side, a->price_, b->price_) ? a : b;
+        }
+
+        auto findBest(Side side) const noexcept -> MEOrdersAtPrice * {
+            const auto s = sideIndex(side);
+            const auto i = side == Side::BUY ? bits_[s].findLastAtOrBelow(num_levels_ - 1)
+                                             : bits_[s].findFirstAtOrAbove(0);
+            const auto window_level = i == LevelBitmap::npos ? nullptr : levels_[i];
+            if (LIKELY(!num_far_levels_) || far_levels_[s].empty())
+                return window_level;
+            return better(side, window_level, side == Side::BUY ? far_levels_[s].back() : far_levels_[s].front());
+        }
+
+        // First overflow level at or above price.
+        static auto farLowerBound(const std::vector<MEOrdersAtPrice *> &far, Price price) noexcept
+            -> std::vector<MEOrdersAtPrice *>::const_iterator {
+            return std::lower_bound(far.begin(), far.end(), price, [](const MEOrdersAtPrice *level, Price p) {
+                return level->price_ < p;
+            });
+        }
+
+        auto inWindow(Price price) const noexcept -> bool {
+            return price >= base_price_ && price - base_price_ < static_cast<Price>(num_levels_);
+        }
+
+        // Moves the window so it is centred on the live window levels plus price, pulling in any overflow levels
+        // that then fit. Returns false, leaving everything in place, if that span is wider than the window.
+        auto recenter(Price price) noexcept -> bool {
+            auto lo = price, hi = price;
+            for (const auto &bits: bits_) {
+                if (bits.empty())
+                    continue;
+                lo = std::min(lo, base_price_ + static_cast<Price>(bits.findFirstAtOrAbove(0)));
+                hi = std::max(hi, base_price_ + static_cast<Price>(bits.findLastAtOrBelow(num_levels_ - 1)));
+            }
+            const auto width = static_cast<Price>(num_levels_);
+            if (hi - lo >= width)
+                return false;
+
+            auto &moved = recenter_levels_;
+            moved.clear();
+            for (auto &bits: bits_) {
+                for (auto i = bits.findFirstAtOrAbove(0); i != LevelBitmap::npos; i = bits.findFirstAtOrAbove(i + 1)) {
+                    moved.push_back(levels_[i]);
+                    levels_[i] = nullptr;
+                    bits.clear(i);
+                }
+            }
+
+            base_price_ = std::clamp((lo + hi) / 2 - width / 2, hi - width + 1, lo);
+            for (auto &far: far_levels_) {
+                const auto kept = std::remove_if(far.begin(), far.end(), [&](MEOrdersAtPrice *level) {
+                    if (!inWindow(level->price_))
+                        return false;
+                    moved.push_back(level);
+                    return true;
+                });
+                num_far_levels_ -= far.end() - kept;
+                far.erase(kept, far.end());
+            }
+            for (const auto level: moved) {
+                levels_[level->price_ - base_price_] = level;
+                bits_[sideIndex(level->side_)].set(level->price_ - base_price_);
+            }
+            return true;
+        }
+
+        const size_t num_levels_;
+        Price base_price_ = 0;
+        std::vector<MEOrdersAtPrice *> levels_;
+        std::array<LevelBitmap, 2> bits_;
+        std::array<MEOrdersAtPrice *, 2> best_{};
+
+        // Levels moved by recenter(), never more than fit in the window.
+        std::vector<MEOrdersAtPrice *> recenter_levels_;
+
+        // Overflow levels per side, ascending by price.
+        std::array<std::vector<MEOrdersAtPrice *>, 2> far_levels_;
+        size_t num_far_levels_ = 0;
+    };
+}
@@ -6,39 +6,84 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <memory>
+#include <algorithm>
+
+#include <sys/mman.h>
 
 #include "macros.h"
 
 namespace LL::Common {
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
     template<typename T>
     class MemPool final {
     public:
-        explicit MemPool(size_t num_elems) : store_(num_elems, {T(), true}) {
+        explicit MemPool(size_t num_elems, bool use_huge_pages = false) : num_elems_(num_elems) {
+            ASSERT(num_elems_ > 0, "MemPool needs at least one element.");
+            mapStore(use_huge_pages);
+
+            for (size_t i = 0; i < num_elems_; ++i) {
+                new(&store_[i]) ObjectBlock{T(), (i + 1 < num_elems_ ? &store_[i + 1] : nullptr), true};
+            }
+            free_head_ = &store_[0];
+
             ASSERT(reinterpret_cast<const ObjectBlock *>
                    (&(store_[0].object_)) == &(store_[0]), "T object should be first member of ObjectBlock.");
         }
 
+        ~MemPool() {
+            std::destroy_n(store_, num_elems_);
+            munmap(store_, mapped_size_);
+            store_ = free_head_ = nullptr;
+        }
+
         template<typename... Args>
         T *allocate(Args &&... args) noexcept {
-            auto obj_block = &(store_[next_free_index_]);
-            ASSERT(obj_block->is_free_,
-                   "Expected free ObjectBlock at index: " + std::to_string(next_free_index_));
+            auto obj_block = free_head_;
+            if (UNLIKELY(!obj_block))
+                FATAL("No free space in pool of size: " + std::to_string(num_elems_));
+
+            free_head_ = obj_block->next_free_;
             T *ret = &(obj_block->object_);
             ret = new(ret)T(args...);
             obj_block->is_free_ = false;
+            obj_block->next_free_ = nullptr;
 
-            updatedNextFreeIndex();
+            ++live_count_;
+            high_water_mark_ = std::max(high_water_mark_, live_count_);
             return ret;
         }
 
         auto deallocate(const T *elem) noexcept {
-            const auto elem_index = (reinterpret_cast<const ObjectBlock *>(elem) - &(store_[0]));
-            ASSERT(elem_index >= 0 && elem_index < store_.size(),
-                   "Invalid element index: " + std::to_string(elem_index));
-            ASSERT(!store_[elem_index].is_free_, "Element already deallocated.");
-            store_[elem_index].is_free_ = true;
+            auto obj_block = const_cast<ObjectBlock *>(reinterpret_cast<const ObjectBlock *>(elem));
+            const auto elem_index = obj_block - store_;
+            if (UNLIKELY(elem_index < 0 || static_cast<size_t>(elem_index) >= num_elems_))
+                FATAL("Invalid element index: " + std::to_string(elem_index));
+            if (UNLIKELY(obj_block->is_free_))
+                FATAL("Element already deallocated.");
+
+            obj_block->is_free_ = true;
+            obj_block->next_free_ = free_head_;
+            free_head_ = obj_block;
+            --live_count_;
+        }
+
+        auto capacity() const noexcept {
+            return num_elems_;
         }
 
+        auto liveCount() const noexcept {
+            return live_count_;
+        }
+
+        auto highWaterMark() const noexcept {
+            return high_water_mark_;
+        }
+
+        auto usingHugePages() const noexcept {
+            return huge_pages_;
+        }
 
         MemPool(const MemPool &) = delete;
 
@@ -51,25 +96,44 @@ namespace LL::Common {
         MemPool() = delete;
 
     private:
-        auto updatedNextFreeIndex() noexcept {
-            const auto initial_free_index = next_free_index_;
-            while (!store_[next_free_index_].is_free_) {
-                ++next_free_index_;
-                if (UNLIKELY(next_free_index_ == store_.size())) {
-                    next_free_index_ = 0;
-                }
-                if (UNLIKELY(initial_free_index == next_free_index_)) {
-                    ASSERT(initial_free_index != next_free_index_, "No free space in pool.");
-                }
-            }
-        }
-
         struct ObjectBlock {
             T object_;
+            ObjectBlock *next_free_ = nullptr;
             bool is_free_ = true;
         };
 
-        std::vector<ObjectBlock> store_;
-        size_t next_free_index_{0};
+        // Hugepage backed stores are prefaulted with MAP_POPULATE. If no 2 MB pages are reserved we fall back to
+        // regular pages and ask for transparent hugepages instead, before the first touch so the pages are faulted in
+        // as hugepages; building the free list in the constructor then prefaults the store.
+        auto mapStore(bool use_huge_pages) noexcept -> void {
+            const auto size = num_elems_ * sizeof(ObjectBlock);
+            void *mem = MAP_FAILED;
+
+            if (use_huge_pages) {
+                mapped_size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+                mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+                huge_pages_ = (mem != MAP_FAILED);
+            }
+
+            if (mem == MAP_FAILED) {
+                mapped_size_ = size;
+                mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                ASSERT(mem != MAP_FAILED, "mmap() failed for MemPool. errno:" + std::string(strerror(errno)));
+                if (use_huge_pages)
+                    madvise(mem, mapped_size_, MADV_HUGEPAGE);
+            }
+
+            store_ = static_cast<ObjectBlock *>(mem);
+        }
+
+        const size_t num_elems_;
+        ObjectBlock *store_ = nullptr;
+        ObjectBlock *free_head_ = nullptr;
+        size_t mapped_size_ = 0;
+        bool huge_pages_ = false;
+
+        size_t live_count_ = 0;
+        size_t high_water_mark_ = 0;
     };
 }
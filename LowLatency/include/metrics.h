@@ -0,0 +1,128 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "macros.h"
+#include "time_utils.h"
+
+namespace LL::Common {
+    // Log-linear histogram in the spirit of HdrHistogram: values below 64 are exact, above that every power of two is
+    // split into 32 sub-buckets so the relative error stays within ~3%. Each histogram has a single writer thread,
+    // which records with plain relaxed stores, and any number of readers taking snapshots.
+    class LatencyHistogram final {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 5;
+        static constexpr size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+        static constexpr size_t EXACT_LIMIT = 2 * SUB_BUCKET_COUNT;
+        static constexpr size_t NUM_BUCKETS = EXACT_LIMIT + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT;
+
+        struct Snapshot {
+            uint64_t count_ = 0;
+            uint64_t max_ = 0;
+            uint64_t sum_ = 0;
+            std::array<uint64_t, NUM_BUCKETS> counts_{};
+
+            auto percentile(double pct) const noexcept -> uint64_t;
+
+            auto toString() const -> std::string;
+        };
+
+        static constexpr auto bucketIndex(uint64_t value) noexcept -> size_t {
+            if (value < EXACT_LIMIT)
+                return value;
+            const size_t msb = 63 - __builtin_clzll(value);
+            const auto mantissa = (value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+            return EXACT_LIMIT + (msb - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT + mantissa;
+        }
+
+        static constexpr auto bucketValue(size_t index) noexcept -> uint64_t {
+            if (index < EXACT_LIMIT)
+                return index;
+            const auto msb = (index - EXACT_LIMIT) / SUB_BUCKET_COUNT + SUB_BUCKET_BITS + 1;
+            const auto mantissa = (index - EXACT_LIMIT) % SUB_BUCKET_COUNT;
+            const auto shift = msb - SUB_BUCKET_BITS;
+            return ((SUB_BUCKET_COUNT + mantissa) << shift) + (1ull << shift) / 2;
+        }
+
+        auto record(uint64_t value) noexcept {
+            auto &bucket = counts_[bucketIndex(value)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            if (value > max_.load(std::memory_order_relaxed))
+                max_.store(value, std::memory_order_relaxed);
+        }
+
+        auto snapshot(Snapshot *snapshot) const noexcept -> void;
+
+    private:
+        std::array<std::atomic<uint64_t>, NUM_BUCKETS> counts_{};
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> count_ = {0};
+        std::atomic<uint64_t> max_ = {0};
+        std::atomic<uint64_t> sum_ = {0};
+    };
+
+    class Counter final {
+    public:
+        auto add(uint64_t n = 1) noexcept {
+            value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        auto value() const noexcept {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> value_ = {0};
+    };
+
+    // Process-wide registry. Metrics are registered by name during component construction, the returned pointers are
+    // stable for the life of the process and are what the hot paths hold on to.
+    class MetricsRegistry final {
+    public:
+        static auto instance() -> MetricsRegistry &;
+
+        auto histogram(const std::string &name) -> LatencyHistogram *;
+
+        auto counter(const std::string &name) -> Counter *;
+
+        auto start(const std::string &file_name, Nanos interval) -> void;
+
+        auto stop() -> void;
+
+        auto dump(std::ostream &os) -> void;
+
+        MetricsRegistry(const MetricsRegistry &) = delete;
+
+        MetricsRegistry(const MetricsRegistry &&) = delete;
+
+        MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+        MetricsRegistry &operator=(const MetricsRegistry &&) = delete;
+
+    private:
+        MetricsRegistry() = default;
+
+        ~MetricsRegistry();
+
+        auto run(std::string file_name, Nanos interval) -> void;
+
+        std::mutex mutex_;
+        std::deque<std::pair<std::string, std::unique_ptr<LatencyHistogram> > > histograms_;
+        std::deque<std::pair<std::string, std::unique_ptr<Counter> > > counters_;
+
+        std::atomic<bool> run_ = {false};
+        std::thread *snapshot_thread_ = nullptr;
+        LatencyHistogram::Snapshot snapshot_;
+    };
+}
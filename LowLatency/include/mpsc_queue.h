@@ -0,0 +1,138 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <thread>
+
+#include "macros.h"
+#include "spsc_queue.h"
+#include "idle_strategy.h"
+
+namespace LL::Common {
+    // Bounded multi-producer / single-consumer queue. Each cell carries a sequence number which tells producers
+    // whether the cell is free for their ticket and tells the consumer whether it has been committed, so producers
+    // only contend on the enqueue ticket and each producer's elements are read back in the order it wrote them.
+    template<typename T>
+    class MPSCQueue final {
+    public:
+        explicit MPSCQueue(size_t num_elems) : mask_(roundUpToPowerOfTwo(num_elems) - 1),
+                                               cells_(mask_ + 1) {
+            for (size_t i = 0; i < cells_.size(); ++i)
+                cells_[i].sequence_.store(i, std::memory_order_relaxed);
+        }
+
+        auto capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+        // Opts the producer into waking consumers parked on the returned signal, must be called before the producer
+        // starts.
+        auto getWakeSignal() noexcept {
+            wake_enabled_ = true;
+            return &wake_signal_;
+        }
+
+        // Producer side, safe to call from any number of threads.
+        auto tryPush(const T &value) noexcept -> bool {
+            auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+            Cell *cell = nullptr;
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const auto seq = cell->sequence_.load(std::memory_order_acquire);
+                const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->data_ = value;
+            cell->sequence_.store(pos + 1, std::memory_order_release);
+            if (UNLIKELY(wake_enabled_))
+                wake_signal_.notify();
+            return true;
+        }
+
+        auto push(const T &value) noexcept {
+            while (UNLIKELY(!tryPush(value)))
+                std::this_thread::yield();
+        }
+
+        // Consumer side.
+        auto peek(size_t max_elems) noexcept -> size_t {
+            while (num_ready_ < max_elems) {
+                const auto pos = dequeue_pos_ + num_ready_;
+                if (cells_[pos & mask_].sequence_.load(std::memory_order_acquire) != pos + 1)
+                    break;
+                ++num_ready_;
+            }
+            return std::min(max_elems, num_ready_);
+        }
+
+        auto getReadSlot(size_t i) noexcept -> const T * {
+            return &cells_[(dequeue_pos_ + i) & mask_].data_;
+        }
+
+        auto consume(size_t n) noexcept {
+            if (UNLIKELY(n > num_ready_))
+                FATAL("Consumed past the committed elements in: " + std::to_string(pthread_self()));
+            for (size_t i = 0; i < n; ++i) {
+                const auto pos = dequeue_pos_ + i;
+                cells_[pos & mask_].sequence_.store(pos + mask_ + 1, std::memory_order_release);
+            }
+            dequeue_pos_ += n;
+            num_ready_ -= n;
+        }
+
+        template<typename F>
+        auto drain(size_t max_elems, F &&func) noexcept -> size_t {
+            const auto n = peek(max_elems);
+            for (size_t i = 0; i < n; ++i)
+                func(getReadSlot(i));
+            if (n)
+                consume(n);
+            return n;
+        }
+
+        auto size() const noexcept {
+            return enqueue_pos_.load(std::memory_order_acquire) - dequeue_pos_;
+        }
+
+        MPSCQueue() = delete;
+
+        MPSCQueue(const MPSCQueue &) = delete;
+
+        MPSCQueue(const MPSCQueue &&) = delete;
+
+        MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+        MPSCQueue &operator=(const MPSCQueue &&) = delete;
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence_ = {0};
+            T data_;
+        };
+
+        const size_t mask_;
+        std::vector<Cell> cells_;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_ = {0};
+
+        alignas(CACHE_LINE_SIZE) WakeSignal wake_signal_;
+        bool wake_enabled_ = false;
+
+        alignas(CACHE_LINE_SIZE) size_t dequeue_pos_ = 0;
+        size_t num_ready_ = 0;
+
+        alignas(CACHE_LINE_SIZE) char padding_[CACHE_LINE_SIZE]{};
+    };
+}
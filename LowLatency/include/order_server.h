@@ -9,12 +9,18 @@
 #include "thread_utils.h"
 #include "macros.h"
 #include "tcp_server.h"
+#include "shm_transport.h"
 
 #include "client_request.h"
 #include "client_response.h"
 #include "fifo_sequencer.h"
 
 namespace LL::Exchange {
+    // Order entry over shared memory for strategies co-located with the exchange, served with the same callbacks as
+    // the TCPServer sessions.
+    using OrderShmServer = Common::ShmServer<OMClientRequest, OMClientResponse>;
+    using OrderShmClient = Common::ShmClient<OMClientRequest, OMClientResponse>;
+
     class OrderServer {
     public:
     private:
@@ -0,0 +1,33 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include "time_utils.h"
+#include "metrics.h"
+
+// Latency probes for the exchange pipeline. START_MEASURE/END_MEASURE log the TSC ticks spent between two points of
+// the same thread as nanoseconds, RECORD_MEASURE records the same interval into a LatencyHistogram without logging
+// and TTT_MEASURE logs a TSC based wall clock timestamp so hops on different threads can
+// be joined on the same order later.
+#define START_MEASURE(TAG) const auto TAG = LL::Common::rdtsc()
+
+#define END_MEASURE(TAG, LOGGER)                                                                  \
+    do {                                                                                          \
+        const auto TAG##_end = LL::Common::rdtsc();                                               \
+        const auto TAG##_nanos = LL::Common::TSCClock::instance().ticksToNanos(TAG##_end - TAG);  \
+        (LOGGER).log("RDTSC " #TAG " %\n", TAG##_nanos);                                         \
+    } while (false)
+
+#define RECORD_MEASURE(TAG, HISTOGRAM)                                                            \
+    do {                                                                                          \
+        const auto TAG##_end = LL::Common::rdtsc();                                               \
+        (HISTOGRAM)->record(LL::Common::TSCClock::instance().ticksToNanos(TAG##_end - TAG));      \
+    } while (false)
+
+#define TTT_MEASURE(TAG, LOGGER)                                                                  \
+    do {                                                                                          \
+        const auto TAG = LL::Common::getCurrentTSCNanos();                                        \
+        (LOGGER).log("TTT " #TAG " %\n", TAG);                                                    \
+    } while (false)
@@ -0,0 +1,230 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include "macros.h"
+
+namespace LL::Common {
+    static_assert(std::endian::native == std::endian::little, "SBE wire format is little endian.");
+
+    constexpr size_t SBEAlignment = 8;
+
+    inline constexpr auto sbeAlign(size_t n) noexcept {
+        return (n + SBEAlignment - 1) / SBEAlignment * SBEAlignment;
+    }
+
+    template<typename T>
+    inline constexpr auto sbeNullValue() noexcept {
+        if constexpr (std::is_enum_v<T>)
+            return static_cast<T>(std::numeric_limits<std::underlying_type_t<T> >::max());
+        else
+            return std::numeric_limits<T>::max();
+    }
+
+    // A field of a message schema. Schemas declare one tag type per field, e.g.
+    // struct PriceField : SBEField<Price> {}, fields added in a later schema version carry that version and read as
+    // null from messages encoded with an older one.
+    template<typename T, uint16_t SinceVersion = 0>
+    struct SBEField {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= SBEAlignment, "SBE fields are scalars.");
+        using type = T;
+        static constexpr uint16_t since_version = SinceVersion;
+    };
+
+    // Fixed block layout of a message, every field at its natural alignment in declaration order and the block padded
+    // to SBEAlignment so consecutive messages in a frame stay aligned. Everything here is resolved at compile time.
+    template<typename... Fields>
+    struct SBELayout {
+    private:
+        static constexpr auto layout = [] {
+            std::array<size_t, sizeof...(Fields) + 1> offsets{};
+            size_t offset = 0, i = 0;
+            ((offset = (offset + sizeof(typename Fields::type) - 1) / sizeof(typename Fields::type) *
+                       sizeof(typename Fields::type),
+              offsets[i++] = offset, offset += sizeof(typename Fields::type)), ...);
+            offsets[i] = offset;
+            return offsets;
+        }();
+
+    public:
+        static constexpr size_t block_length = sbeAlign(layout.back());
+
+        template<typename F>
+        static constexpr auto offsetOf() noexcept {
+            static_assert((std::is_same_v<F, Fields> || ...), "Field is not part of this message.");
+            size_t index = 0, i = 0;
+            ((std::is_same_v<F, Fields> ? (index = i, ++i) : ++i), ...);
+            return layout[index];
+        }
+    };
+
+    // Every message starts with this header, block_length_ lets a decoder skip fields appended by newer versions.
+    struct SBEMessageHeader {
+        uint16_t block_length_ = 0;
+        uint16_t template_id_ = 0;
+        uint16_t schema_id_ = 0;
+        uint16_t version_ = 0;
+    };
+
+    // Leads a batch of messages, the sequence number of message i in the frame is first_seq_num_ + i.
+    struct SBEFrameHeader {
+        uint64_t first_seq_num_ = 0;
+        uint32_t frame_length_ = 0;
+        uint16_t num_messages_ = 0;
+        uint16_t reserved_ = 0;
+    };
+
+    static_assert(sizeof(SBEMessageHeader) == 8 && sizeof(SBEFrameHeader) == 16);
+
+    // Message definitions provide template_id, schema_id, version and a Layout.
+    template<typename Message>
+    class SBEEncoder final {
+    public:
+        using Layout = typename Message::Layout;
+
+        explicit SBEEncoder(char *buffer) noexcept : buffer_(buffer) {
+        }
+
+        static constexpr auto encodedLength() noexcept {
+            return sizeof(SBEMessageHeader) + Layout::block_length;
+        }
+
+        auto writeHeader() noexcept -> SBEEncoder & {
+            const SBEMessageHeader header{static_cast<uint16_t>(Layout::block_length), Message::template_id,
+                                          Message::schema_id, Message::version};
+            memcpy(buffer_, &header, sizeof(header));
+            return *this;
+        }
+
+        template<typename F>
+        auto set(typename F::type value) noexcept -> SBEEncoder & {
+            memcpy(buffer_ + sizeof(SBEMessageHeader) + Layout::template offsetOf<F>(), &value, sizeof(value));
+            return *this;
+        }
+
+    private:
+        char *buffer_ = nullptr;
+    };
+
+    // Reads fields in place from a received buffer, honouring the block length and version the sender encoded with.
+    template<typename Message>
+    class SBEDecoder final {
+    public:
+        using Layout = typename Message::Layout;
+
+        explicit SBEDecoder(const char *buffer) noexcept : buffer_(buffer) {
+            memcpy(&header_, buffer_, sizeof(header_));
+        }
+
+        auto header() const noexcept -> const SBEMessageHeader & {
+            return header_;
+        }
+
+        auto encodedLength() const noexcept {
+            return sizeof(SBEMessageHeader) + header_.block_length_;
+        }
+
+        template<typename F>
+        auto get() const noexcept -> typename F::type {
+            constexpr auto offset = Layout::template offsetOf<F>();
+            if constexpr (F::since_version > 0) {
+                if (header_.version_ < F::since_version || header_.block_length_ < offset + sizeof(typename F::type))
+                    return sbeNullValue<typename F::type>();
+            }
+            typename F::type value;
+            memcpy(&value, buffer_ + sizeof(SBEMessageHeader) + offset, sizeof(value));
+            return value;
+        }
+
+    private:
+        const char *buffer_ = nullptr;
+        SBEMessageHeader header_;
+    };
+
+    // Builds one frame in a caller owned buffer: a frame header followed by any mix of messages.
+    class SBEFrameEncoder final {
+    public:
+        SBEFrameEncoder(char *buffer, size_t capacity) noexcept : buffer_(buffer), capacity_(capacity) {
+            ASSERT(capacity_ >= sizeof(SBEFrameHeader), "SBE frame buffer too small:" + std::to_string(capacity_));
+        }
+
+        auto begin(uint64_t first_seq_num) noexcept {
+            header_ = {first_seq_num, sizeof(SBEFrameHeader), 0, 0};
+        }
+
+        template<typename Message>
+        auto room() const noexcept {
+            return capacity_ - header_.frame_length_ >= SBEEncoder<Message>::encodedLength();
+        }
+
+        // Encoder for the next message with its header already written, the caller checks room<Message>() first.
+        template<typename Message>
+        auto add() noexcept {
+            SBEEncoder<Message> encoder(buffer_ + header_.frame_length_);
+            encoder.writeHeader();
+            header_.frame_length_ += SBEEncoder<Message>::encodedLength();
+            ++header_.num_messages_;
+            return encoder;
+        }
+
+        auto empty() const noexcept {
+            return !header_.num_messages_;
+        }
+
+        // Writes the frame header and returns the frame length.
+        auto finish() noexcept {
+            memcpy(buffer_, &header_, sizeof(header_));
+            return static_cast<size_t>(header_.frame_length_);
+        }
+
+        SBEFrameEncoder() = delete;
+
+        SBEFrameEncoder(const SBEFrameEncoder &) = delete;
+
+        SBEFrameEncoder(const SBEFrameEncoder &&) = delete;
+
+        SBEFrameEncoder &operator=(const SBEFrameEncoder &) = delete;
+
+        SBEFrameEncoder &operator=(const SBEFrameEncoder &&) = delete;
+
+    private:
+        char *buffer_ = nullptr;
+        const size_t capacity_;
+        SBEFrameHeader header_;
+    };
+
+    // Walks the complete frames at the front of data, calling func(seq_num, const SBEMessageHeader &, const char *msg)
+    // per message with msg pointing at its message header, and returns the number of bytes consumed. A trailing
+    // partial frame is left for the next call.
+    template<typename F>
+    inline auto parseSBEFrames(const char *data, size_t len, F &&func) noexcept {
+        size_t offset = 0;
+        while (len - offset >= sizeof(SBEFrameHeader)) {
+            SBEFrameHeader frame;
+            memcpy(&frame, data + offset, sizeof(frame));
+            if (UNLIKELY(frame.frame_length_ < sizeof(SBEFrameHeader)) || len - offset < frame.frame_length_)
+                break;
+
+            size_t msg_offset = offset + sizeof(SBEFrameHeader);
+            const auto frame_end = offset + frame.frame_length_;
+            for (uint16_t i = 0; i < frame.num_messages_ && frame_end - msg_offset >= sizeof(SBEMessageHeader); ++i) {
+                SBEMessageHeader header;
+                memcpy(&header, data + msg_offset, sizeof(header));
+                if (UNLIKELY(frame_end - msg_offset - sizeof(SBEMessageHeader) < header.block_length_))
+                    break;
+                func(frame.first_seq_num_ + i, header, data + msg_offset);
+                msg_offset += sizeof(SBEMessageHeader) + header.block_length_;
+            }
+            offset = frame_end;
+        }
+        return offset;
+    }
+}
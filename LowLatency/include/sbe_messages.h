@@ -0,0 +1,127 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include "sbe_codec.h"
+#include "client_request.h"
+#include "client_response.h"
+#include "market_update.h"
+
+namespace LL::Exchange {
+    constexpr uint16_t SBESchemaId = 1;
+    constexpr uint16_t SBESchemaVersion = 1;
+
+    // Wire schema of the exchange messages. Fields are declared widest first so the blocks carry no padding, new
+    // fields go at the end of a message with the schema version they were added in.
+    namespace SBE {
+        struct TypeField : SBEField<uint8_t> {};
+        struct ClientIdField : SBEField<ClientId> {};
+        struct TickerIdField : SBEField<TickerId> {};
+        struct OrderIdField : SBEField<OrderId> {};
+        struct ClientOrderIdField : SBEField<OrderId> {};
+        struct MarketOrderIdField : SBEField<OrderId> {};
+        struct SideField : SBEField<Side> {};
+        struct PriceField : SBEField<Price> {};
+        struct QuantityField : SBEField<Quantity> {};
+        struct ExecQtyField : SBEField<Quantity> {};
+        struct LeavesQtyField : SBEField<Quantity> {};
+        struct PriorityField : SBEField<Priority> {};
+
+        struct ClientRequest {
+            static constexpr uint16_t template_id = 1;
+            static constexpr uint16_t schema_id = SBESchemaId;
+            static constexpr uint16_t version = SBESchemaVersion;
+            using Layout = SBELayout<OrderIdField, PriceField, QuantityField, ClientIdField, TickerIdField, TypeField,
+                SideField>;
+        };
+
+        struct ClientResponse {
+            static constexpr uint16_t template_id = 2;
+            static constexpr uint16_t schema_id = SBESchemaId;
+            static constexpr uint16_t version = SBESchemaVersion;
+            using Layout = SBELayout<ClientOrderIdField, MarketOrderIdField, PriceField, ExecQtyField, LeavesQtyField,
+                ClientIdField, TickerIdField, TypeField, SideField>;
+        };
+
+        struct MarketUpdate {
+            static constexpr uint16_t template_id = 3;
+            static constexpr uint16_t schema_id = SBESchemaId;
+            static constexpr uint16_t version = SBESchemaVersion;
+            using Layout = SBELayout<OrderIdField, PriceField, QuantityField, PriorityField, TickerIdField, TypeField,
+                SideField>;
+        };
+    }
+
+    inline auto sbeEncode(SBEEncoder<SBE::ClientRequest> encoder, const MEClientRequest &request) noexcept {
+        encoder.set<SBE::OrderIdField>(request.order_id_)
+                .set<SBE::PriceField>(request.price_)
+                .set<SBE::QuantityField>(request.quantity_)
+                .set<SBE::ClientIdField>(request.client_id_)
+                .set<SBE::TickerIdField>(request.ticker_id_)
+                .set<SBE::TypeField>(static_cast<uint8_t>(request.type_))
+                .set<SBE::SideField>(request.side_);
+    }
+
+    inline auto sbeEncode(SBEEncoder<SBE::ClientResponse> encoder, const MEClientResponse &response) noexcept {
+        encoder.set<SBE::ClientOrderIdField>(response.client_order_id_)
+                .set<SBE::MarketOrderIdField>(response.market_order_id_)
+                .set<SBE::PriceField>(response.price_)
+                .set<SBE::ExecQtyField>(response.exec_qty_)
+                .set<SBE::LeavesQtyField>(response.leaves_qty_)
+                .set<SBE::ClientIdField>(response.client_id_)
+                .set<SBE::TickerIdField>(response.ticker_id_)
+                .set<SBE::TypeField>(static_cast<uint8_t>(response.type_))
+                .set<SBE::SideField>(response.side_);
+    }
+
+    inline auto sbeEncode(SBEEncoder<SBE::MarketUpdate> encoder, const MEMarketUpdate &update) noexcept {
+        encoder.set<SBE::OrderIdField>(update.order_id_)
+                .set<SBE::PriceField>(update.price_)
+                .set<SBE::QuantityField>(update.quantity_)
+                .set<SBE::PriorityField>(update.priority_)
+                .set<SBE::TickerIdField>(update.ticker_id_)
+                .set<SBE::TypeField>(static_cast<uint8_t>(update.type_))
+                .set<SBE::SideField>(update.side_);
+    }
+
+    // Decoders into the internal structs, for consumers that need a copy rather than reading the fields in place.
+    inline auto sbeDecode(const SBEDecoder<SBE::ClientRequest> &decoder) noexcept {
+        MEClientRequest request;
+        request.type_ = static_cast<ClientRequestType>(decoder.get<SBE::TypeField>());
+        request.client_id_ = decoder.get<SBE::ClientIdField>();
+        request.ticker_id_ = decoder.get<SBE::TickerIdField>();
+        request.order_id_ = decoder.get<SBE::OrderIdField>();
+        request.side_ = decoder.get<SBE::SideField>();
+        request.price_ = decoder.get<SBE::PriceField>();
+        request.quantity_ = decoder.get<SBE::QuantityField>();
+        return request;
+    }
+
+    inline auto sbeDecode(const SBEDecoder<SBE::ClientResponse> &decoder) noexcept {
+        MEClientResponse response;
+        response.type_ = static_cast<ClientResponseType>(decoder.get<SBE::TypeField>());
+        response.client_id_ = decoder.get<SBE::ClientIdField>();
+        response.ticker_id_ = decoder.get<SBE::TickerIdField>();
+        response.client_order_id_ = decoder.get<SBE::ClientOrderIdField>();
+        response.market_order_id_ = decoder.get<SBE::MarketOrderIdField>();
+        response.side_ = decoder.get<SBE::SideField>();
+        response.price_ = decoder.get<SBE::PriceField>();
+        response.exec_qty_ = decoder.get<SBE::ExecQtyField>();
+        response.leaves_qty_ = decoder.get<SBE::LeavesQtyField>();
+        return response;
+    }
+
+    inline auto sbeDecode(const SBEDecoder<SBE::MarketUpdate> &decoder) noexcept {
+        MEMarketUpdate update;
+        update.type_ = static_cast<MarketUpdateType>(decoder.get<SBE::TypeField>());
+        update.order_id_ = decoder.get<SBE::OrderIdField>();
+        update.ticker_id_ = decoder.get<SBE::TickerIdField>();
+        update.side_ = decoder.get<SBE::SideField>();
+        update.price_ = decoder.get<SBE::PriceField>();
+        update.quantity_ = decoder.get<SBE::QuantityField>();
+        update.priority_ = decoder.get<SBE::PriorityField>();
+        return update;
+    }
+}
@@ -0,0 +1,127 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "matching_engine.h"
+
+namespace LL::Exchange {
+    constexpr size_t ME_MAX_SHARDS = 64;
+
+    // Runs the matching engine as num_shards MatchingEngine threads, each owning a disjoint set of tickers (ticker i
+    // goes to shard ticker_shards[i] if given, else i % num_shards) with its own request, response and market update
+    // queues. A front thread routes incoming requests to the owning shard by ticker_id_ and merges the
+    // shards' responses and market updates into the single outgoing queues. A ticker is only ever handled by one
+    // shard and each shard queue is FIFO, so responses and market updates stay in order per ticker; there is no
+    // ordering across tickers on different shards.
+    class ShardedMatchingEngine final {
+    public:
+        ShardedMatchingEngine(ClientRequestLFQueue *client_requests,
+                              ClientResponseLFQueue *client_responses,
+                              MEMarketUpdateRing *market_updates,
+                              size_t num_shards,
+                              const InstrumentRegistry &instruments = InstrumentRegistry::uniform(ME_MAX_TICKERS),
+                              const std::vector<size_t> &ticker_shards = {});
+
+        ShardedMatchingEngine(ClientRequestMPSCQueue *client_requests,
+                              ClientResponseLFQueue *client_responses,
+                              MEMarketUpdateRing *market_updates,
+                              size_t num_shards,
+                              const InstrumentRegistry &instruments = InstrumentRegistry::uniform(ME_MAX_TICKERS),
+                              const std::vector<size_t> &ticker_shards = {});
+
+        ~ShardedMatchingEngine();
+
+        auto start() -> void;
+
+        auto stop() -> void;
+
+        // Must be called before start(). The shards use type as is; the front thread has no single queue to park on,
+        // so PARK falls back to BACKOFF there.
+        auto setIdleStrategy(IdleStrategyType type) -> void;
+
+        // Must be called before start(), see MatchingEngine::setBatchSize().
+        auto setBatchSize(size_t batch_size) -> void;
+
+        auto numShards() const noexcept {
+            return shards_.size();
+        }
+
+        auto shardOf(TickerId ticker_id) const noexcept -> size_t {
+            return LIKELY(ticker_id < ticker_shard_.size()) ? ticker_shard_[ticker_id] : ticker_id % shards_.size();
+        }
+
+        ShardedMatchingEngine() = delete;
+
+        ShardedMatchingEngine(const ShardedMatchingEngine &) = delete;
+
+        ShardedMatchingEngine(const ShardedMatchingEngine &&) = delete;
+
+        auto operator=(const ShardedMatchingEngine &) -> ShardedMatchingEngine & = delete;
+
+        auto operator=(const ShardedMatchingEngine &&) -> ShardedMatchingEngine & = delete;
+
+    private:
+        struct Shard {
+            std::unique_ptr<ClientRequestLFQueue> requests_;
+            std::unique_ptr<ClientResponseLFQueue> responses_;
+            std::unique_ptr<MEMarketUpdateRing> market_updates_;
+            MEMarketUpdateRing::ConsumerId md_consumer_id_ = 0;
+            std::unique_ptr<MatchingEngine> engine_;
+        };
+
+        // Routes what fits into the shard request queues, publishing once per shard, and leaves the rest queued so a
+        // full shard never blocks the merge that lets it drain.
+        template<typename Q>
+        auto routeRequests(Q *requests) noexcept {
+            const auto num_requests = requests->peek(requests->capacity());
+            size_t routed = 0;
+            for (; routed < num_requests; ++routed) {
+                const auto client_request = requests->getReadSlot(routed);
+                const auto shard = shardOf(client_request->ticker_id_);
+                auto shard_requests = shards_[shard].requests_.get();
+                auto &pending = pending_requests_[shard];
+                if (UNLIKELY(shard_requests->reserve(pending + 1) <= pending))
+                    break;
+                *shard_requests->getWriteSlot(pending++) = *client_request;
+            }
+            for (size_t shard = 0; shard < shards_.size(); ++shard) {
+                if (pending_requests_[shard]) {
+                    shards_[shard].requests_->publish(pending_requests_[shard]);
+                    pending_requests_[shard] = 0;
+                }
+            }
+            if (routed) {
+                requests->consume(routed);
+                requests_routed_->add(routed);
+            }
+            return routed;
+        }
+
+        auto mergeShard(Shard &shard) noexcept -> size_t;
+
+        auto run() noexcept -> void;
+
+        ClientRequestLFQueue *incoming_requests_ = nullptr;
+        ClientRequestMPSCQueue *incoming_gateway_requests_ = nullptr;
+        ClientResponseLFQueue *outgoing_ogw_responses_ = nullptr;
+        MEMarketUpdateRing *outgoing_md_updates_ = nullptr;
+
+        std::vector<Shard> shards_;
+        std::vector<size_t> ticker_shard_;
+        std::array<size_t, ME_MAX_SHARDS> pending_requests_{};
+
+        volatile bool run_{false};
+        IdleStrategy idle_strategy_;
+
+        std::string time_str_;
+        Logger logger_;
+
+        Counter *requests_routed_ = nullptr;
+        LatencyHistogram *merge_batch_ = nullptr;
+    };
+}
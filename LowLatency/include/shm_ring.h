@@ -0,0 +1,121 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+
+#include "macros.h"
+
+namespace LL::Common {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory rings need lock free 64 bit atomics.");
+
+    // Indices of a ShmRing, placed at the front of the ring's shared memory. Zero filled memory is a valid empty ring.
+    struct ShmRingIndices {
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> write_index_ = {0};
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> read_index_ = {0};
+    };
+
+    // Single-producer / single-consumer ring over memory shared between two processes, with the same reserve/publish
+    // and peek/consume protocol as SPSCQueue. The shared memory only holds the indices and the slots, every process
+    // attaches its own ShmRing view which keeps the cached copy of the other side's index.
+    template<typename T>
+    class ShmRing final {
+    public:
+        static_assert(std::is_trivially_copyable_v<T>, "ShmRing elements must be trivially copyable.");
+
+        static constexpr auto bytesFor(size_t capacity) noexcept {
+            return (sizeof(ShmRingIndices) + capacity * sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE *
+                   CACHE_LINE_SIZE;
+        }
+
+        ShmRing(void *mem, size_t capacity) noexcept
+            : indices_(static_cast<ShmRingIndices *>(mem)),
+              slots_(reinterpret_cast<T *>(static_cast<char *>(mem) + sizeof(ShmRingIndices))),
+              mask_(capacity - 1) {
+            ASSERT(capacity && !(capacity & mask_), "ShmRing capacity must be a power of two:" + std::to_string(capacity));
+            resync();
+        }
+
+        auto capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+        // Producer side.
+        auto reserve(size_t n) noexcept -> size_t {
+            if (UNLIKELY(write_index_local_ + n - cached_read_index_ > capacity())) {
+                cached_read_index_ = indices_->read_index_.load(std::memory_order_acquire);
+            }
+            return std::min(n, capacity() - (write_index_local_ - cached_read_index_));
+        }
+
+        auto getWriteSlot(size_t i) noexcept {
+            return &slots_[(write_index_local_ + i) & mask_];
+        }
+
+        auto publish(size_t n) noexcept {
+            write_index_local_ += n;
+            indices_->write_index_.store(write_index_local_, std::memory_order_release);
+        }
+
+        auto tryPush(const T &value) noexcept {
+            if (UNLIKELY(!reserve(1)))
+                return false;
+            *getWriteSlot(0) = value;
+            publish(1);
+            return true;
+        }
+
+        // Consumer side.
+        auto peek(size_t max_elems) noexcept -> size_t {
+            if (cached_write_index_ - read_index_local_ < max_elems) {
+                cached_write_index_ = indices_->write_index_.load(std::memory_order_acquire);
+            }
+            return std::min(max_elems, cached_write_index_ - read_index_local_);
+        }
+
+        auto getReadSlot(size_t i) noexcept -> const T * {
+            return &slots_[(read_index_local_ + i) & mask_];
+        }
+
+        auto consume(size_t n) noexcept {
+            read_index_local_ += n;
+            indices_->read_index_.store(read_index_local_, std::memory_order_release);
+        }
+
+        // Empties the ring, only while neither side is using it.
+        auto reset() noexcept {
+            indices_->write_index_.store(0, std::memory_order_relaxed);
+            indices_->read_index_.store(0, std::memory_order_release);
+            write_index_local_ = cached_write_index_ = read_index_local_ = cached_read_index_ = 0;
+        }
+
+        // Reloads the shared indices after the other side reset() the ring.
+        auto resync() noexcept {
+            write_index_local_ = cached_write_index_ = indices_->write_index_.load(std::memory_order_acquire);
+            read_index_local_ = cached_read_index_ = indices_->read_index_.load(std::memory_order_acquire);
+        }
+
+        ShmRing() = delete;
+
+        ShmRing(const ShmRing &) = delete;
+
+        ShmRing(const ShmRing &&) = delete;
+
+        ShmRing &operator=(const ShmRing &) = delete;
+
+        ShmRing &operator=(const ShmRing &&) = delete;
+
+    private:
+        ShmRingIndices *indices_ = nullptr;
+        T *slots_ = nullptr;
+        const size_t mask_;
+
+        size_t write_index_local_ = 0;
+        size_t cached_read_index_ = 0;
+        size_t read_index_local_ = 0;
+        size_t cached_write_index_ = 0;
+    };
+}
@@ -0,0 +1,380 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <functional>
+
+#include "shm_ring.h"
+#include "tcp_socket.h"
+#include "time_utils.h"
+
+namespace LL::Common {
+    constexpr size_t ShmDefaultRingCapacity = 64 * 1024;
+    constexpr uint64_t ShmChannelMagic = 0x4c4c53484d434832; // "LLSHMCH2"
+    // How often the server checks that the process of an attached client is still alive.
+    constexpr Nanos ShmClientProbeInterval = 100 * NANOS_TO_MILLS;
+
+    template<typename T>
+    struct ShmMessage {
+        Nanos send_time_ = 0;
+        T msg_;
+    };
+
+    struct ShmChannelHeader {
+        uint64_t magic_ = 0;
+        uint64_t request_size_ = 0;
+        uint64_t response_size_ = 0;
+        uint64_t capacity_ = 0;
+        // A client attaches by storing its pid and bumping session_, the server empties both rings and acknowledges
+        // by copying session_ to ready_session_. client_pid_ goes back to 0 when the client detaches.
+        std::atomic<uint64_t> session_ = {0};
+        std::atomic<uint64_t> ready_session_ = {0};
+        std::atomic<int32_t> client_pid_ = {0};
+    };
+
+    // One client's channel, a file under /dev/shm holding a header, the request ring (client -> server) and the
+    // response ring (server -> client). The server creates and owns the file, the client maps it by path.
+    template<typename Request, typename Response>
+    class ShmChannel final {
+    public:
+        using RequestRing = ShmRing<ShmMessage<Request> >;
+        using ResponseRing = ShmRing<ShmMessage<Response> >;
+
+        static constexpr auto headerBytes() noexcept {
+            return (sizeof(ShmChannelHeader) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+        }
+
+        static constexpr auto bytesFor(size_t capacity) noexcept {
+            return headerBytes() + RequestRing::bytesFor(capacity) + ResponseRing::bytesFor(capacity);
+        }
+
+        ShmChannel(const std::string &path, bool create, size_t capacity = ShmDefaultRingCapacity)
+            : path_(path), owner_(create) {
+            const auto fd = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0600);
+            ASSERT(fd >= 0, "ShmChannel open() failed for " + path + " error:" + std::string(std::strerror(errno)));
+
+            if (create) {
+                ASSERT(ftruncate(fd, static_cast<off_t>(bytesFor(capacity))) == 0,
+                       "ShmChannel ftruncate() failed for " + path + " error:" + std::string(std::strerror(errno)));
+            } else {
+                ShmChannelHeader header;
+                constexpr auto header_size = static_cast<ssize_t>(offsetof(ShmChannelHeader, session_));
+                ASSERT(pread(fd, &header, header_size, 0) == header_size && header.magic_ == ShmChannelMagic,
+                       "ShmChannel " + path + " is not initialized.");
+                ASSERT(header.request_size_ == sizeof(Request) && header.response_size_ == sizeof(Response),
+                       "ShmChannel " + path + " message sizes do not match.");
+                capacity = header.capacity_;
+            }
+
+            size_ = bytesFor(capacity);
+            auto mem = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+            ::close(fd);
+            ASSERT(mem != MAP_FAILED, "ShmChannel mmap() failed for " + path + " error:" + std::string(std::strerror(errno)));
+            mem_ = static_cast<char *>(mem);
+
+            header_ = reinterpret_cast<ShmChannelHeader *>(mem_);
+            if (create) {
+                // The file is zero filled, which is two empty rings, the magic is written last to mark it ready.
+                header_->request_size_ = sizeof(Request);
+                header_->response_size_ = sizeof(Response);
+                header_->capacity_ = capacity;
+                std::atomic_ref<uint64_t>(header_->magic_).store(ShmChannelMagic, std::memory_order_release);
+            }
+
+            request_ring_ = new RequestRing(mem_ + headerBytes(), capacity);
+            response_ring_ = new ResponseRing(mem_ + headerBytes() + RequestRing::bytesFor(capacity), capacity);
+        }
+
+        ~ShmChannel() {
+            delete request_ring_;
+            delete response_ring_;
+            munmap(mem_, size_);
+            if (owner_)
+                unlink(path_.c_str());
+        }
+
+        auto path() const noexcept -> const std::string & {
+            return path_;
+        }
+
+        auto header() noexcept {
+            return header_;
+        }
+
+        auto requestRing() noexcept {
+            return request_ring_;
+        }
+
+        auto responseRing() noexcept {
+            return response_ring_;
+        }
+
+        ShmChannel() = delete;
+
+        ShmChannel(const ShmChannel &) = delete;
+
+        ShmChannel(const ShmChannel &&) = delete;
+
+        ShmChannel &operator=(const ShmChannel &) = delete;
+
+        ShmChannel &operator=(const ShmChannel &&) = delete;
+
+    private:
+        const std::string path_;
+        const bool owner_;
+
+        char *mem_ = nullptr;
+        size_t size_ = 0;
+        ShmChannelHeader *header_ = nullptr;
+        RequestRing *request_ring_ = nullptr;
+        ResponseRing *response_ring_ = nullptr;
+    };
+
+    // Gateway side of the shared memory transport, a drop-in for TCPServer for strategies on the same host. Each
+    // client gets a TCPSocket without a file descriptor so the gateway keeps its TCPServer callbacks unchanged:
+    // requests are copied out of the ring into inbound_data_ before recv_callback_, and whole responses the gateway
+    // send()s are moved from outbound_data_ into the response ring.
+    template<typename Request, typename Response>
+    class ShmServer final {
+    public:
+        using Channel = ShmChannel<Request, Response>;
+
+        explicit ShmServer(Logger &logger, size_t socket_buffer_size = TCPBufferSize,
+                           const std::string &metrics_prefix = "Common/ShmServer")
+            : socket_buffer_size_(socket_buffer_size), metrics_prefix_(metrics_prefix), logger_(logger) {
+        }
+
+        ~ShmServer() {
+            for (auto &connection: connections_) {
+                delete connection.socket_;
+                delete connection.channel_;
+            }
+        }
+
+        // Creates one channel per client, <prefix>.<client id>, clients attach by mapping that file.
+        auto listen(const std::string &prefix, size_t num_clients, size_t capacity = ShmDefaultRingCapacity) -> void {
+            for (size_t i = 0; i < num_clients; ++i) {
+                const auto path = prefix + "." + std::to_string(i);
+                connections_.push_back({new Channel(path, true, capacity),
+                                        new TCPSocket(logger_, socket_buffer_size_, metrics_prefix_ + "/TCPSocket"),
+                                        false});
+                logger_.log("%:% %() % created shm channel:%\n", __FILE__, __LINE__, __FUNCTION__,
+                            Common::getCurrentTimeStr(&time_str_), path);
+            }
+        }
+
+        // Picks up clients attaching, detaching or dying. A new session starts with both rings and the socket buffers
+        // empty, so nothing left over from the previous client of the channel is delivered to either side.
+        auto poll() noexcept -> void {
+            const auto now = getCurrentNanos();
+            for (auto &connection: connections_) {
+                auto header = connection.channel_->header();
+                const auto session = header->session_.load(std::memory_order_acquire);
+                const auto pid = header->client_pid_.load(std::memory_order_acquire);
+
+                if (connection.attached_ && (session != connection.session_ || pid != connection.pid_ ||
+                                             (now >= connection.next_probe_time_ && !clientAlive(connection)))) {
+                    logger_.log("%:% %() % client detached:% pid:%\n", __FILE__, __LINE__, __FUNCTION__,
+                                Common::getCurrentTimeStr(&time_str_), connection.channel_->path(), connection.pid_);
+                    if (disconnect_callback_)
+                        disconnect_callback_(connection.socket_);
+                    connection.attached_ = false;
+                    continue;
+                }
+
+                if (!connection.attached_ && pid && session != header->ready_session_.load(std::memory_order_relaxed)) {
+                    resetConnection(connection);
+                    connection.attached_ = true;
+                    connection.session_ = session;
+                    connection.pid_ = pid;
+                    connection.next_probe_time_ = now + ShmClientProbeInterval;
+                    connection.socket_->recv_callback_ = recv_callback_;
+                    header->ready_session_.store(session, std::memory_order_release);
+                    logger_.log("%:% %() % client attached:% pid:% session:%\n", __FILE__, __LINE__, __FUNCTION__,
+                                Common::getCurrentTimeStr(&time_str_), connection.channel_->path(), pid, session);
+                }
+            }
+        }
+
+        auto sendAndRecv() noexcept -> void {
+            bool recv = false;
+            for (auto &connection: connections_) {
+                if (!connection.attached_)
+                    continue;
+                recv |= recvRequests(connection);
+                sendResponses(connection);
+            }
+            if (recv && recv_finished_callback_)
+                recv_finished_callback_();
+        }
+
+        auto numConnections() const noexcept {
+            return connections_.size();
+        }
+
+        ShmServer() = delete;
+
+        ShmServer(const ShmServer &) = delete;
+
+        ShmServer(const ShmServer &&) = delete;
+
+        ShmServer &operator=(const ShmServer &) = delete;
+
+        ShmServer &operator=(const ShmServer &&) = delete;
+
+    private:
+        struct Connection {
+            Channel *channel_ = nullptr;
+            TCPSocket *socket_ = nullptr;
+            bool attached_ = false;
+            uint64_t session_ = 0;
+            int32_t pid_ = 0;
+            Nanos next_probe_time_ = 0;
+        };
+
+        // A client that died without detaching leaves its pid behind, clear it so the channel reads as free.
+        auto clientAlive(Connection &connection) noexcept -> bool {
+            connection.next_probe_time_ = getCurrentNanos() + ShmClientProbeInterval;
+            if (kill(connection.pid_, 0) == 0 || errno != ESRCH)
+                return true;
+            auto pid = connection.pid_;
+            connection.channel_->header()->client_pid_.compare_exchange_strong(pid, 0, std::memory_order_acq_rel);
+            return false;
+        }
+
+        auto resetConnection(Connection &connection) noexcept -> void {
+            connection.channel_->requestRing()->reset();
+            connection.channel_->responseRing()->reset();
+            connection.socket_->inbound_data_.consume(connection.socket_->inbound_data_.size());
+            connection.socket_->outbound_data_.consume(connection.socket_->outbound_data_.size());
+        }
+
+        auto recvRequests(Connection &connection) noexcept -> bool {
+            auto ring = connection.channel_->requestRing();
+            auto socket = connection.socket_;
+            const auto max_requests = socket->inbound_data_.freeSpace() / sizeof(Request);
+            const auto num_requests = ring->peek(max_requests);
+            if (!num_requests)
+                return false;
+
+            const auto rx_time = ring->getReadSlot(0)->send_time_;
+            auto dest = socket->inbound_data_.reserve(num_requests * sizeof(Request));
+            for (size_t i = 0; i < num_requests; ++i)
+                memcpy(dest + i * sizeof(Request), &ring->getReadSlot(i)->msg_, sizeof(Request));
+            socket->inbound_data_.commit(num_requests * sizeof(Request));
+            ring->consume(num_requests);
+
+            socket->last_rx_time_ = rx_time;
+            if (socket->recv_callback_)
+                socket->recv_callback_(socket, rx_time);
+            return true;
+        }
+
+        auto sendResponses(Connection &connection) noexcept -> void {
+            auto ring = connection.channel_->responseRing();
+            auto &outbound = connection.socket_->outbound_data_;
+            const auto num_responses = ring->reserve(outbound.size() / sizeof(Response));
+            if (!num_responses)
+                return;
+
+            const auto send_time = getCurrentNanos();
+            for (size_t i = 0; i < num_responses; ++i) {
+                auto slot = ring->getWriteSlot(i);
+                slot->send_time_ = send_time;
+                memcpy(&slot->msg_, outbound.data() + i * sizeof(Response), sizeof(Response));
+            }
+            ring->publish(num_responses);
+            outbound.consume(num_responses * sizeof(Response));
+        }
+
+        size_t socket_buffer_size_ = TCPBufferSize;
+        const std::string metrics_prefix_;
+        std::vector<Connection> connections_;
+
+    public:
+        std::function<void(TCPSocket *s, Nanos rx_time)> recv_callback_{nullptr};
+        std::function<void()> recv_finished_callback_{nullptr};
+        std::function<void(TCPSocket *s)> disconnect_callback_{nullptr};
+
+    private:
+        std::string time_str_;
+        Logger &logger_;
+    };
+
+    // Strategy side of the shared memory transport. The client starts a new session on the channel and can only send
+    // and receive once the server's poll() has emptied the rings for it, see ready().
+    template<typename Request, typename Response>
+    class ShmClient final {
+    public:
+        explicit ShmClient(const std::string &path) : channel_(path, false) {
+            auto header = channel_.header();
+            header->client_pid_.store(getpid(), std::memory_order_release);
+            session_ = header->session_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        }
+
+        ~ShmClient() {
+            channel_.header()->client_pid_.store(0, std::memory_order_release);
+        }
+
+        auto ready() noexcept {
+            if (UNLIKELY(!ready_)) {
+                if (channel_.header()->ready_session_.load(std::memory_order_acquire) != session_)
+                    return false;
+                channel_.requestRing()->resync();
+                channel_.responseRing()->resync();
+                ready_ = true;
+            }
+            return true;
+        }
+
+        auto send(const Request &request) noexcept {
+            auto ring = channel_.requestRing();
+            if (UNLIKELY(!ready() || !ring->reserve(1)))
+                return false;
+            auto slot = ring->getWriteSlot(0);
+            slot->send_time_ = getCurrentNanos();
+            slot->msg_ = request;
+            ring->publish(1);
+            return true;
+        }
+
+        // Hands every available response to func(const Response &, Nanos send_time), returns how many.
+        template<typename F>
+        auto recv(F &&func) noexcept -> size_t {
+            if (UNLIKELY(!ready()))
+                return 0;
+            auto ring = channel_.responseRing();
+            const auto num_responses = ring->peek(ring->capacity());
+            for (size_t i = 0; i < num_responses; ++i) {
+                const auto slot = ring->getReadSlot(i);
+                func(slot->msg_, slot->send_time_);
+            }
+            ring->consume(num_responses);
+            return num_responses;
+        }
+
+        ShmClient() = delete;
+
+        ShmClient(const ShmClient &) = delete;
+
+        ShmClient(const ShmClient &&) = delete;
+
+        ShmClient &operator=(const ShmClient &) = delete;
+
+        ShmClient &operator=(const ShmClient &&) = delete;
+
+    private:
+        ShmChannel<Request, Response> channel_;
+        uint64_t session_ = 0;
+        bool ready_ = false;
+    };
+}
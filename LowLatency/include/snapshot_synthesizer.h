@@ -12,18 +12,27 @@
 #include "mcast_socket.h"
 #include "mem_pool.h"
 #include "logging.h"
+#include "idle_strategy.h"
 #include "market_update.h"
 #include "me_order.h"
+#include "client_order_map.h"
+#include "instrument_registry.h"
 
 using namespace LL::Common;
 
 namespace LL::Exchange {
+    // Live orders keyed by (ticker_id, market order id); the table grows and shrinks with the number of live orders
+    // rather than being sized for every ticker and order id.
+    using TickerOrderMap = ClientOrderMap<MEMarketUpdate>;
+
+    // The order pool holds every order the instruments can have resting at once.
     class SnapshotSynthesizer {
     public:
-        SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates,
+        SnapshotSynthesizer(MEMarketUpdateRing *market_updates,
                             const std::string &iface,
                             const std::string &snapshot_ip,
-                            int snapshot_port);
+                            int snapshot_port,
+                            const InstrumentRegistry &instruments = InstrumentRegistry::uniform(ME_MAX_TICKERS));
 
         ~SnapshotSynthesizer();
 
@@ -31,7 +40,9 @@ namespace LL::Exchange {
 
         auto stop() -> void;
 
-        auto addToSnapshot(const MDPMarketUpdate *market_update);
+        auto setIdleStrategy(IdleStrategyType type) -> void;
+
+        auto addToSnapshot(size_t seq_num, const MEMarketUpdate *market_update);
 
         auto publishSnapshot();
 
@@ -48,13 +59,15 @@ namespace LL::Exchange {
         auto operator=(const SnapshotSynthesizer &&) -> SnapshotSynthesizer & = delete;
 
     private:
-        MDPMarketUpdateLFQueue *snapshot_md_updates_ = nullptr;
+        MEMarketUpdateRing *snapshot_md_updates_ = nullptr;
+        MEMarketUpdateRing::ConsumerId md_consumer_id_ = 0;
         Logger logger_;
         volatile bool run_ = false;
+        IdleStrategy idle_strategy_{IdleStrategyType::BACKOFF};
         std::string time_str_;
         McastSocket snapshot_socket_;
 
-        std::array<std::array<MEMarketUpdate *, ME_MAX_ORDER_IDS>, ME_MAX_TICKERS> ticker_orders_;
+        TickerOrderMap ticker_orders_;
         size_t last_inc_seq_num_{0};
         Nanos last_snapshot_time_{0};
 
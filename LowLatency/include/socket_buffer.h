@@ -0,0 +1,106 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+
+#include "macros.h"
+
+namespace LL::Common {
+    // Per-connection byte buffer. Producers reserve() contiguous space, encode straight into it and commit() what they
+    // wrote, consumers parse in place from data() and consume() only what they fully used, the remainder carries over
+    // to the next round. Both indices rewind to the front whenever the buffer drains, and the unread tail is only
+    // moved when a reservation does not fit behind it.
+    class SocketBuffer final {
+    public:
+        explicit SocketBuffer(size_t capacity) : store_(capacity) {
+        }
+
+        auto capacity() const noexcept {
+            return store_.size();
+        }
+
+        // Consumer side.
+        auto data() noexcept {
+            return store_.data() + read_index_;
+        }
+
+        auto size() const noexcept {
+            return write_index_ - read_index_;
+        }
+
+        auto empty() const noexcept {
+            return read_index_ == write_index_;
+        }
+
+        auto consume(size_t n) noexcept {
+            ASSERT(n <= size(), "SocketBuffer consume:" + std::to_string(n) + " past size:" + std::to_string(size()));
+            read_index_ += n;
+            if (read_index_ == write_index_)
+                read_index_ = write_index_ = 0;
+        }
+
+        // Producer side.
+        auto freeSpace() const noexcept {
+            return capacity() - size();
+        }
+
+        auto reserve(size_t n) noexcept -> char * {
+            if (UNLIKELY(capacity() - write_index_ < n)) {
+                if (n > freeSpace() || pinned_)
+                    return nullptr;
+                compact();
+            }
+            return store_.data() + write_index_;
+        }
+
+        auto reserveAll() noexcept {
+            return reserve(freeSpace());
+        }
+
+        auto commit(size_t n) noexcept {
+            ASSERT(write_index_ + n <= capacity(), "SocketBuffer commit:" + std::to_string(n) + " past capacity.");
+            write_index_ += n;
+        }
+
+        // While pinned the unread bytes never move, e.g. while the kernel still reads them for an asynchronous send.
+        auto setPinned(bool pinned) noexcept {
+            pinned_ = pinned;
+        }
+
+        auto append(const void *data, size_t len) noexcept {
+            auto dest = reserve(len);
+            if (UNLIKELY(!dest))
+                return false;
+            memcpy(dest, data, len);
+            commit(len);
+            return true;
+        }
+
+        SocketBuffer() = delete;
+
+        SocketBuffer(const SocketBuffer &) = delete;
+
+        SocketBuffer(const SocketBuffer &&) = delete;
+
+        SocketBuffer &operator=(const SocketBuffer &) = delete;
+
+        SocketBuffer &operator=(const SocketBuffer &&) = delete;
+
+    private:
+        auto compact() noexcept -> void {
+            const auto len = size();
+            memmove(store_.data(), store_.data() + read_index_, len);
+            read_index_ = 0;
+            write_index_ = len;
+        }
+
+        std::vector<char> store_;
+        size_t read_index_ = 0;
+        size_t write_index_ = 0;
+        bool pinned_ = false;
+    };
+}
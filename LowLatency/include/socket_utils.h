@@ -18,6 +18,11 @@
 #include <arpa/inet.h>
 #include <ifaddrs.h>
 #include <fcntl.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
 
 #include "macros.h"
 #include "logging.h"
@@ -30,12 +35,14 @@ namespace LL::Common {
         bool is_udp_ = false;
         bool is_listening_ = false;
         bool needs_so_timestamp_ = false;
+        bool needs_tx_timestamp_ = false;
 
         auto toString() const {
             std::stringstream ss;
             ss << "SocketCfg[ip: " << ip_ << ", iface: " << iface_ << ", port: " << port_
                     << ", is_udp: " << is_udp_ << ", is_listening: " << is_listening_
-                    << ", needs_so_timestamp: " << needs_so_timestamp_ << "]";
+                    << ", needs_so_timestamp: " << needs_so_timestamp_
+                    << ", needs_tx_timestamp: " << needs_tx_timestamp_ << "]";
 
             return ss.str();
         }
@@ -77,10 +84,75 @@ namespace LL::Common {
                           reinterpret_cast<void *>(&one), sizeof(one)) != -1;
     }
 
-    inline auto setSOTimestamp(int fd) -> bool {
-        int one = 1;
-        return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP,
-                          reinterpret_cast<void *>(&one), sizeof(one)) != -1;
+    // Software receive stamps, plus hardware ones where the NIC has them switched on by enableHardwareTimestamps().
+    // Transmit stamps come back on the socket error queue tagged with a per-socket counter, see readTxTimestamp().
+    inline auto setSOTimestamp(int fd, bool tx_stamps = false) -> bool {
+        int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE |
+                    SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        if (tx_stamps)
+            flags |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_TX_HARDWARE |
+                    SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+        return setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING,
+                          reinterpret_cast<void *>(&flags), sizeof(flags)) != -1;
+    }
+
+    // Needs CAP_NET_ADMIN and a PTP capable driver. Hardware stamps are in the NIC clock, which may be free running or
+    // TAI offset, so they are only compared with other hardware stamps, see getHardwareTimestamp().
+    inline auto enableHardwareTimestamps(int fd, const std::string &iface) -> bool {
+        hwtstamp_config config{};
+        config.tx_type = HWTSTAMP_TX_ON;
+        config.rx_filter = HWTSTAMP_FILTER_ALL;
+        ifreq ifr{};
+        strncpy(ifr.ifr_name, iface.c_str(), IFNAMSIZ - 1);
+        ifr.ifr_data = reinterpret_cast<char *>(&config);
+        return ioctl(fd, SIOCSHWTSTAMP, &ifr) == 0;
+    }
+
+    constexpr size_t TimestampCtrlSize = CMSG_SPACE(sizeof(scm_timestamping)) +
+                                         CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in));
+
+    // Stamp ts_index (0 software, 2 raw hardware) of the message, 0 if it carries none.
+    inline auto getTimestamp(msghdr *msg, size_t ts_index) noexcept -> Nanos {
+        for (auto cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                scm_timestamping stamps;
+                memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+                return stamps.ts[ts_index].tv_sec * NANOS_TO_SECS + stamps.ts[ts_index].tv_nsec;
+            }
+        }
+        return 0;
+    }
+
+    // The kernel software stamp, in CLOCK_REALTIME like getCurrentNanos() so the two can be subtracted, 0 if none.
+    inline auto getKernelTimestamp(msghdr *msg) noexcept -> Nanos {
+        return getTimestamp(msg, 0);
+    }
+
+    // The NIC stamp, only meaningful against other hardware stamps, 0 if none.
+    inline auto getHardwareTimestamp(msghdr *msg) noexcept -> Nanos {
+        return getTimestamp(msg, 2);
+    }
+
+    // Pops one transmit stamp off the error queue, *tx_id is the OPT_ID counter of the stamped send.
+    inline auto readTxTimestamp(int fd, uint32_t *tx_id, Nanos *tx_time) noexcept -> bool {
+        char ctrl[TimestampCtrlSize];
+        msghdr msg{};
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return false;
+
+        *tx_time = getKernelTimestamp(&msg);
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                sock_extended_err err;
+                memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+                if (err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+                    *tx_id = err.ee_data;
+            }
+        }
+        return true;
     }
 
     inline auto join(int fd, const std::string &ip) -> bool {
@@ -152,7 +224,7 @@ namespace LL::Common {
             }
 
             if (socket_cfg.needs_so_timestamp_) {
-                ASSERT(setSOTimestamp(socket_fd),
+                ASSERT(setSOTimestamp(socket_fd, socket_cfg.needs_tx_timestamp_),
                        "setSOTimestamp() failed. errno:" + std::string(strerror(errno)));
             }
         }
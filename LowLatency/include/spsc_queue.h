@@ -0,0 +1,123 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+
+#include "macros.h"
+#include "idle_strategy.h"
+
+namespace LL::Common {
+    // Single-producer / single-consumer ring. Indices grow monotonically and are masked into a power-of-two
+    // store, the producer and consumer indices live on separate cache lines and each side keeps a private
+    // copy of the other side's index so the shared line is only touched when the cached view runs out.
+    template<typename T>
+    class SPSCQueue final {
+    public:
+        explicit SPSCQueue(size_t num_elems) : mask_(roundUpToPowerOfTwo(num_elems) - 1),
+                                               store_(mask_ + 1, T()) {
+        }
+
+        auto capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+        // Opts the producer into waking consumers parked on the returned signal, must be called before the producer
+        // starts.
+        auto getWakeSignal() noexcept {
+            wake_enabled_ = true;
+            return &wake_signal_;
+        }
+
+        // Producer side.
+        auto reserve(size_t n) noexcept -> size_t {
+            if (UNLIKELY(write_index_local_ + n - cached_read_index_ > capacity())) {
+                cached_read_index_ = read_index_.load(std::memory_order_acquire);
+            }
+            return std::min(n, capacity() - (write_index_local_ - cached_read_index_));
+        }
+
+        auto getWriteSlot(size_t i) noexcept {
+            return &store_[(write_index_local_ + i) & mask_];
+        }
+
+        auto publish(size_t n) noexcept {
+            write_index_local_ += n;
+            write_index_.store(write_index_local_, std::memory_order_release);
+            if (UNLIKELY(wake_enabled_))
+                wake_signal_.notify();
+        }
+
+        auto getNextToWriteTo() noexcept {
+            if (UNLIKELY(!reserve(1)))
+                FATAL("SPSCQueue full, capacity:" + std::to_string(capacity()));
+            return getWriteSlot(0);
+        }
+
+        auto updateWriteIndex() noexcept {
+            publish(1);
+        }
+
+        // Consumer side.
+        auto peek(size_t max_elems) noexcept -> size_t {
+            if (cached_write_index_ - read_index_local_ < max_elems) {
+                cached_write_index_ = write_index_.load(std::memory_order_acquire);
+            }
+            return std::min(max_elems, cached_write_index_ - read_index_local_);
+        }
+
+        auto getReadSlot(size_t i) noexcept {
+            return &store_[(read_index_local_ + i) & mask_];
+        }
+
+        auto consume(size_t n) noexcept {
+            if (UNLIKELY(read_index_local_ + n > cached_write_index_))
+                FATAL("Consumed past the published elements in: " + std::to_string(pthread_self()));
+            read_index_local_ += n;
+            read_index_.store(read_index_local_, std::memory_order_release);
+        }
+
+        auto getNextToRead() noexcept -> T * {
+            return (peek(1) ? getReadSlot(0) : nullptr);
+        }
+
+        auto updateReadIndex() noexcept {
+            consume(1);
+        }
+
+        auto size() const noexcept {
+            return write_index_.load(std::memory_order_acquire) - read_index_.load(std::memory_order_acquire);
+        }
+
+        SPSCQueue() = delete;
+
+        SPSCQueue(const SPSCQueue &) = delete;
+
+        SPSCQueue(const SPSCQueue &&) = delete;
+
+        SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+        SPSCQueue &operator=(const SPSCQueue &&) = delete;
+
+    private:
+        const size_t mask_;
+        std::vector<T> store_;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> write_index_ = {0};
+        size_t write_index_local_ = 0;
+        size_t cached_read_index_ = 0;
+
+        alignas(CACHE_LINE_SIZE) WakeSignal wake_signal_;
+        bool wake_enabled_ = false;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> read_index_ = {0};
+        size_t read_index_local_ = 0;
+        size_t cached_write_index_ = 0;
+
+        alignas(CACHE_LINE_SIZE) char padding_[CACHE_LINE_SIZE]{};
+    };
+}
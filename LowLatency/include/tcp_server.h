@@ -6,32 +6,72 @@
 #include "tcp_socket.h"
 
 namespace LL::Common {
+    constexpr int TCPServerMaxEventsPerPoll = 1024;
+
     struct TCPServer {
-        explicit TCPServer(Logger &logger): listener_socket_(logger), logger_(logger) {
+        explicit TCPServer(Logger &logger, size_t socket_buffer_size = TCPBufferSize,
+                           int max_events_per_poll = TCPServerMaxEventsPerPoll,
+                           const std::string &metrics_prefix = "Common/TCPServer")
+            : listener_socket_(logger, 0, metrics_prefix + "/TCPSocket"), socket_buffer_size_(socket_buffer_size),
+              metrics_prefix_(metrics_prefix), events_(max_events_per_poll), logger_(logger),
+              send_and_recv_latency_(MetricsRegistry::instance().histogram(metrics_prefix + "/sendAndRecv_ns")) {
         }
 
+        ~TCPServer();
+
         auto listen(const std::string &iface, int port) -> void;
 
         auto poll() noexcept -> void;
 
         auto sendAndRecv() noexcept -> void;
 
+        auto getConnection(int fd) const noexcept -> TCPSocket * {
+            return (fd >= 0 && static_cast<size_t>(fd) < connections_.size()) ? connections_[fd] : nullptr;
+        }
+
+        auto numConnections() const noexcept {
+            return num_connections_;
+        }
+
+        TCPServer() = delete;
+
+        TCPServer(const TCPServer &) = delete;
+
+        TCPServer(const TCPServer &&) = delete;
+
+        TCPServer &operator=(const TCPServer &) = delete;
+
+        TCPServer &operator=(const TCPServer &&) = delete;
+
     private:
-        auto addToEpollList(TCPSocket *socket);
+        auto addToEpollList(TCPSocket *socket, uint32_t events) -> bool;
+
+        auto acceptConnections() noexcept -> void;
+
+        auto closeConnection(TCPSocket *socket) noexcept -> void;
 
     public:
         int epoll_fd_ = -1;
         TCPSocket listener_socket_;
+        size_t socket_buffer_size_ = TCPBufferSize;
+        const std::string metrics_prefix_;
 
-        epoll_event events_[1024];
+        std::vector<epoll_event> events_;
 
-        std::vector<TCPSocket *> receive_sockets_, send_sockets_;
+        // Live connections indexed by fd, and the sockets that have work pending. A socket is on the ready list at
+        // most once and stays there until needsService() turns false.
+        std::vector<TCPSocket *> connections_;
+        size_t num_connections_ = 0;
+        std::vector<TCPSocket *> ready_sockets_;
 
         std::function<void(TCPSocket *s,
                            Nanos rx_time)> recv_callback_{nullptr};
         std::function<void()> recv_finished_callback_{nullptr};
+        std::function<void(TCPSocket *s)> disconnect_callback_{nullptr};
 
         std::string time_str_;
         Logger &logger_;
+
+        LatencyHistogram *send_and_recv_latency_ = nullptr;
     };
 }
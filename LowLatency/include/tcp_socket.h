@@ -7,14 +7,26 @@
 #include <functional>
 #include "socket_utils.h"
 #include "logging.h"
+#include "perf_utils.h"
+#include "socket_buffer.h"
 
 namespace LL::Common {
-    constexpr size_t TCPBufferSize = 64 * 1024 * 1024;
+    constexpr size_t TCPBufferSize = 16 * 1024;
 
+    // The histograms are single writer, so sockets serviced from different threads need their own metrics_prefix, the
+    // servers key their sockets by the server's prefix.
     struct TCPSocket {
-        explicit TCPSocket(Logger &logger) : logger_(logger) {
-            outbound_data_.resize(TCPBufferSize);
-            inbound_data_.resize(TCPBufferSize);
+        explicit TCPSocket(Logger &logger, size_t buffer_size = TCPBufferSize,
+                           const std::string &metrics_prefix = "Common/TCPSocket")
+            : outbound_data_(buffer_size), inbound_data_(buffer_size),
+              logger_(logger),
+              read_to_callback_latency_(MetricsRegistry::instance().histogram(metrics_prefix + "/read_to_callback_ns")),
+              kernel_to_user_latency_(MetricsRegistry::instance().histogram(metrics_prefix + "/kernel_to_user_ns")) {
+        }
+
+        ~TCPSocket() {
+            if (socket_fd_ >= 0)
+                close(socket_fd_);
         }
 
         auto connect(const std::string &ip,
@@ -31,21 +43,63 @@ namespace LL::Common {
 
         TCPSocket &operator=(const TCPSocket &&) = delete;
 
-        auto send(const void *data, size_t len) noexcept -> void;
+        auto send(const void *data, size_t len) noexcept -> bool;
+
+        // Zero-copy send, encode into the returned space and commit the bytes written. nullptr if the unsent data
+        // does not leave len bytes free.
+        auto reserveSend(size_t len) noexcept {
+            return outbound_data_.reserve(len);
+        }
+
+        auto commitSend(size_t len) noexcept {
+            outbound_data_.commit(len);
+            markReady();
+        }
+
+        auto hasPendingSend() const noexcept {
+            return !outbound_data_.empty();
+        }
 
         auto sendAndRecv() noexcept -> bool;
 
+        auto recv() noexcept -> bool;
+
+        auto flushSend() noexcept -> void;
+
+        // Whether the owner still has to service this socket without waiting for another edge from epoll.
+        auto needsService() const noexcept {
+            return recv_ready_ || closed_ || (hasPendingSend() && !send_blocked_);
+        }
+
+        auto markReady() noexcept -> void {
+            if (ready_list_ && !in_ready_list_) {
+                in_ready_list_ = true;
+                ready_list_->push_back(this);
+            }
+        }
+
         int socket_fd_{-1};
 
+        // Readiness state kept by the owning TCPServer, recv_ready_ is set on EPOLLIN and cleared once a read comes
+        // back short, send_blocked_ is set when the kernel buffer fills and cleared on EPOLLOUT.
+        bool recv_ready_ = true;
+        bool send_blocked_ = false;
+        bool closed_ = false;
+        bool in_ready_list_ = false;
+        Nanos last_rx_time_ = 0;
+        std::vector<TCPSocket *> *ready_list_ = nullptr;
 
-        std::vector<char> outbound_data_;
-        std::vector<char> inbound_data_;
-        size_t next_send_valid_index_{0};
-        size_t next_recv_valid_index_{0};
+        // recv_callback_ parses in place from inbound_data_ and consumes the complete messages, a partial message is
+        // kept for the next read.
+        SocketBuffer outbound_data_;
+        SocketBuffer inbound_data_;
 
         sockaddr_in socket_attrib_{};
         std::function<void(TCPSocket *s, Nanos rx_time)> recv_callback_ = nullptr;
         std::string time_str_;
         Logger &logger_;
+
+        LatencyHistogram *read_to_callback_latency_ = nullptr;
+        LatencyHistogram *kernel_to_user_latency_ = nullptr;
     };
 }
@@ -6,9 +6,17 @@
 #include <iostream>
 #include <atomic>
 #include <thread>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <string>
+#include <unordered_map>
 #include <unistd.h>
 
 #include <sys/syscall.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
 
 namespace LL::Common {
     inline auto setThreadCore(int core_id) noexcept {
@@ -19,23 +27,104 @@ namespace LL::Common {
         return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
     }
 
+    inline auto setThreadRealtimePriority(int priority) noexcept {
+        const sched_param param{priority};
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+    struct ThreadCfg {
+        int core_id_ = -1;
+        int rt_priority_ = 0;
+
+        auto toString() const {
+            return "ThreadCfg[core:" + std::to_string(core_id_) + " rt_priority:" + std::to_string(rt_priority_) + "]";
+        }
+    };
+
+    // Process-wide thread placement. The core map is declared once at startup and keyed by thread name prefix, e.g.
+    // "Exchange/MatchingEngine" or "Common/Logger", the longest matching prefix wins. While the start gate is held,
+    // new threads finish their setup and then wait for releaseStart() so the whole pipeline goes live together.
+    class ThreadManager final {
+    public:
+        static auto instance() -> ThreadManager & {
+            static ThreadManager thread_manager;
+            return thread_manager;
+        }
+
+        auto setCoreMap(std::unordered_map<std::string, ThreadCfg> core_map) {
+            std::lock_guard lock(mutex_);
+            core_map_ = std::move(core_map);
+        }
+
+        auto getThreadCfg(const std::string &name) -> ThreadCfg {
+            std::lock_guard lock(mutex_);
+            ThreadCfg thread_cfg;
+            size_t best_len = 0;
+            for (const auto &[prefix, cfg]: core_map_) {
+                if (prefix.size() >= best_len && name.compare(0, prefix.size(), prefix) == 0) {
+                    best_len = prefix.size();
+                    thread_cfg = cfg;
+                }
+            }
+            return thread_cfg;
+        }
+
+        auto lockMemory() noexcept {
+            return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        }
+
+        auto holdStart() noexcept {
+            start_gate_open_.store(false, std::memory_order_release);
+        }
+
+        auto releaseStart() noexcept {
+            start_gate_open_.store(true, std::memory_order_release);
+        }
+
+        auto waitForStart() const noexcept {
+            while (!start_gate_open_.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+    private:
+        ThreadManager() = default;
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, ThreadCfg> core_map_;
+        std::atomic<bool> start_gate_open_ = {true};
+    };
+
     template<class T, class... A>
     inline auto createAndStartThread(
         int core_id, const std::string &name,
         T &&func, A &&... args) noexcept {
-        auto t = new std::thread([&]() {
-            if (core_id >= 0 && !setThreadCore(core_id)) {
-                std::cerr << "Failed to set core affinity for " << name << " " << pthread_self() << " to " << core_id <<
-                        std::endl;
+        auto thread_cfg = ThreadManager::instance().getThreadCfg(name);
+        if (core_id >= 0)
+            thread_cfg.core_id_ = core_id;
+
+        auto started = std::make_shared<std::atomic<bool> >(false);
+        auto t = new std::thread([thread_cfg, name, started,
+                func = std::forward<T>(func), args_tuple = std::make_tuple(std::forward<A>(args)...)]() mutable {
+            if (thread_cfg.core_id_ >= 0 && !setThreadCore(thread_cfg.core_id_)) {
+                std::cerr << "Failed to set core affinity for " << name << " " << pthread_self() << " to " <<
+                        thread_cfg.core_id_ << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            if (thread_cfg.rt_priority_ > 0 && !setThreadRealtimePriority(thread_cfg.rt_priority_)) {
+                std::cerr << "Failed to set SCHED_FIFO priority for " << name << " " << pthread_self() << " to " <<
+                        thread_cfg.rt_priority_ << std::endl;
                 exit(EXIT_FAILURE);
             }
-            std::cerr << "Set core affinity for " << name << " " << pthread_self() << " to " << core_id << std::endl;
+            std::cerr << "Set " << thread_cfg.toString() << " for " << name << " " << pthread_self() << std::endl;
+
+            started->store(true, std::memory_order_release);
+            ThreadManager::instance().waitForStart();
 
-            std::forward<T>(func)((std::forward<A>(args))...);
+            std::apply(func, std::move(args_tuple));
         });
 
-        using namespace std::chrono_literals;
-        std::this_thread::sleep_for(1s);
+        while (!started->load(std::memory_order_acquire))
+            std::this_thread::yield();
         return t;
     }
 }
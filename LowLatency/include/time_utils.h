@@ -6,6 +6,15 @@
 #include <string>
 #include <chrono>
 #include <ctime>
+#include <cstdint>
+#include <thread>
+#include <cstring>
+
+#include "macros.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace LL::Common {
     using Nanos = int64_t;
@@ -21,11 +30,83 @@ namespace LL::Common {
             std::chrono::system_clock::now().time_since_epoch()).count();
     }
 
+    inline auto rdtsc() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    inline auto rdtscp() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned aux;
+        return __rdtscp(&aux);
+#else
+        return rdtsc();
+#endif
+    }
+
+    // Converts TSC ticks to nanoseconds. The tick rate is measured once against steady_clock and anchored to
+    // system_clock, so toNanos() is comparable with getCurrentNanos() but costs an rdtsc and a multiply.
+    class TSCClock final {
+    public:
+        static auto instance() noexcept -> const TSCClock & {
+            static const TSCClock clock;
+            return clock;
+        }
+
+        auto ticksToNanos(uint64_t ticks) const noexcept -> Nanos {
+            return static_cast<Nanos>(static_cast<double>(ticks) * nanos_per_tick_);
+        }
+
+        auto toNanos(uint64_t tsc) const noexcept -> Nanos {
+            return base_nanos_ + static_cast<Nanos>(static_cast<double>(static_cast<int64_t>(tsc - base_tsc_)) *
+                                                    nanos_per_tick_);
+        }
+
+        auto nanosPerTick() const noexcept {
+            return nanos_per_tick_;
+        }
+
+    private:
+        TSCClock() noexcept {
+            using namespace std::chrono_literals;
+            const auto steady_start = std::chrono::steady_clock::now();
+            const auto tsc_start = rdtscp();
+            std::this_thread::sleep_for(10ms);
+            const auto steady_end = std::chrono::steady_clock::now();
+            const auto tsc_end = rdtscp();
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_end - steady_start);
+            nanos_per_tick_ = static_cast<double>(elapsed.count()) / static_cast<double>(tsc_end - tsc_start);
+            base_tsc_ = rdtscp();
+            base_nanos_ = getCurrentNanos();
+        }
+
+        double nanos_per_tick_ = 1.0;
+        uint64_t base_tsc_ = 0;
+        Nanos base_nanos_ = 0;
+    };
+
+    inline auto getCurrentTSCNanos() noexcept {
+        return TSCClock::instance().toNanos(rdtsc());
+    }
+
+    // ctime_r() only runs when the wall clock second changes, every other call reuses the cached text.
     inline auto &getCurrentTimeStr(std::string *time_str) {
+        thread_local time_t last_time = 0;
+        thread_local char last_time_str[32] = {'\0'};
+
         const auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-        time_str->assign(ctime(&time));
-        if (!time_str->empty())
-            time_str->at(time_str->length() - 1) = '\0';
+        if (UNLIKELY(time != last_time)) {
+            last_time = time;
+            ctime_r(&time, last_time_str);
+            if (const auto len = strlen(last_time_str); len && last_time_str[len - 1] == '\n')
+                last_time_str[len - 1] = '\0';
+        }
+        time_str->assign(last_time_str);
         return *time_str;
     }
 }
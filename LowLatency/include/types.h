@@ -18,6 +18,7 @@ namespace LL::Common {
     constexpr size_t ME_MAX_NUM_CLIENTS = 256;
     constexpr size_t ME_MAX_ORDER_IDS = 1024 * 1024;
     constexpr size_t ME_MAX_PRICE_LEVELS = 256;
+    constexpr size_t ME_PRICE_LADDER_LEVELS = 16 * 1024;
 
 
     using OrderId = uint64_t;
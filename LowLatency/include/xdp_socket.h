@@ -0,0 +1,125 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <linux/if_xdp.h>
+
+#include "logging.h"
+
+namespace LL::Common {
+    constexpr uint32_t XdpDefaultNumFrames = 4096;
+    constexpr uint32_t XdpFrameSize = 2048;
+    constexpr uint32_t XdpRecvBatch = 64;
+
+    // Producer/consumer indices of an AF_XDP ring mapped from the kernel, plus our cached copy of our own side.
+    struct XdpRing {
+        uint32_t *producer_ = nullptr;
+        uint32_t *consumer_ = nullptr;
+        uint32_t *flags_ = nullptr;
+        void *descs_ = nullptr;
+        uint32_t mask_ = 0;
+        void *map_ = nullptr;
+        size_t map_size_ = 0;
+    };
+
+    // AF_XDP receive socket for one UDP flow on one NIC queue. A small XDP program redirects IPv4 UDP datagrams for
+    // the given destination ip:port into this socket and passes everything else on to the kernel stack. Frames live
+    // in a UMEM shared with the kernel, recv() hands the UDP payloads to the caller in place and gives the frames
+    // back through the fill ring. Tries driver mode and zero-copy first and falls back to generic (skb) mode and
+    // copy mode, which is what veth and loopback test setups get.
+    class XdpSocket final {
+    public:
+        explicit XdpSocket(Logger &logger, uint32_t num_frames = XdpDefaultNumFrames)
+            : num_frames_(num_frames), logger_(logger) {
+        }
+
+        ~XdpSocket();
+
+        auto init(const std::string &iface, int queue_id, const std::string &ip, int port) -> bool;
+
+        // Calls func(const char *payload, size_t len) for up to XdpRecvBatch datagrams, the payload is only valid
+        // inside the call. Returns the number of datagrams.
+        template<typename F>
+        auto recv(F &&func) noexcept -> size_t {
+            const auto available = std::atomic_ref<uint32_t>(*rx_.producer_).load(std::memory_order_acquire) -
+                                   rx_cons_;
+            const auto n = std::min(available, XdpRecvBatch);
+            if (!n) {
+                wakeupIfNeeded();
+                return 0;
+            }
+
+            const auto descs = static_cast<const xdp_desc *>(rx_.descs_);
+            const auto fill_addrs = static_cast<uint64_t *>(fill_.descs_);
+            for (uint32_t i = 0; i < n; ++i) {
+                const auto &desc = descs[(rx_cons_ + i) & rx_.mask_];
+                const char *payload = nullptr;
+                size_t len = 0;
+                if (LIKELY(udpPayload(umem_ + desc.addr, desc.len, &payload, &len)))
+                    func(payload, len);
+                fill_addrs[(fill_prod_ + i) & fill_.mask_] = desc.addr - desc.addr % XdpFrameSize;
+            }
+
+            rx_cons_ += n;
+            std::atomic_ref<uint32_t>(*rx_.consumer_).store(rx_cons_, std::memory_order_release);
+            fill_prod_ += n;
+            std::atomic_ref<uint32_t>(*fill_.producer_).store(fill_prod_, std::memory_order_release);
+            wakeupIfNeeded();
+            return n;
+        }
+
+        auto zeroCopy() const noexcept {
+            return zero_copy_;
+        }
+
+        XdpSocket() = delete;
+
+        XdpSocket(const XdpSocket &) = delete;
+
+        XdpSocket(const XdpSocket &&) = delete;
+
+        XdpSocket &operator=(const XdpSocket &) = delete;
+
+        XdpSocket &operator=(const XdpSocket &&) = delete;
+
+    private:
+        static auto udpPayload(const char *frame, size_t len, const char **payload, size_t *payload_len) noexcept
+            -> bool;
+
+        auto wakeupIfNeeded() noexcept -> void;
+
+        auto createUmem() -> bool;
+
+        auto mapRing(XdpRing *ring, const xdp_ring_offset &offsets, uint32_t size, size_t desc_size,
+                     off_t pgoff) -> bool;
+
+        auto bindSocket(int ifindex, int queue_id) -> bool;
+
+        auto loadProgram(int ifindex, uint32_t ip, uint16_t port) -> bool;
+
+        const uint32_t num_frames_;
+
+        char *umem_ = nullptr;
+        size_t umem_size_ = 0;
+
+        int xsk_fd_ = -1;
+        int map_fd_ = -1;
+        int prog_fd_ = -1;
+        int link_fd_ = -1;
+        bool zero_copy_ = false;
+
+        XdpRing rx_;
+        XdpRing fill_;
+        XdpRing completion_;
+        uint32_t rx_cons_ = 0;
+        uint32_t fill_prod_ = 0;
+
+        std::string time_str_;
+        Logger &logger_;
+    };
+}
@@ -0,0 +1,55 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#include "instrument_registry.h"
+
+#include <fstream>
+
+namespace LL::Exchange {
+    auto InstrumentRegistry::load(const std::string &path) -> InstrumentRegistry {
+        std::ifstream file(path);
+        ASSERT(file.is_open(), "Could not open instrument file:" + path);
+
+        InstrumentRegistry registry;
+        std::string line;
+        for (size_t line_num = 1; std::getline(file, line); ++line_num) {
+            std::istringstream fields(line);
+            std::string first;
+            if (!(fields >> first) || first[0] == '#')
+                continue;
+
+            InstrumentCfg instrument;
+            instrument.ticker_id_ = static_cast<TickerId>(std::stoul(first));
+            fields >> instrument.symbol_ >> instrument.max_orders_ >> instrument.max_price_levels_
+                    >> instrument.price_ladder_levels_;
+            ASSERT(!instrument.symbol_.empty(), path + ":" + std::to_string(line_num) + " missing symbol.");
+            registry.add(instrument);
+        }
+        return registry;
+    }
+
+    auto InstrumentRegistry::uniform(size_t num_instruments) -> InstrumentRegistry {
+        InstrumentRegistry registry;
+        for (size_t i = 0; i < num_instruments; ++i) {
+            InstrumentCfg instrument;
+            instrument.ticker_id_ = static_cast<TickerId>(i);
+            instrument.symbol_ = std::to_string(i);
+            registry.add(instrument);
+        }
+        return registry;
+    }
+
+    auto InstrumentRegistry::add(const InstrumentCfg &instrument) -> void {
+        ASSERT(instrument.ticker_id_ != TickerId_INVALID, "Invalid ticker for instrument:" + instrument.toString());
+        ASSERT(instrument.max_orders_ && instrument.max_price_levels_ && instrument.price_ladder_levels_,
+               "Instrument pools must not be empty:" + instrument.toString());
+        if (instrument.ticker_id_ >= instruments_.size())
+            instruments_.resize(instrument.ticker_id_ + 1);
+        ASSERT(instruments_[instrument.ticker_id_].ticker_id_ == TickerId_INVALID,
+               "Duplicate instrument:" + instrument.toString());
+
+        instruments_[instrument.ticker_id_] = instrument;
+        ++num_instruments_;
+    }
+}
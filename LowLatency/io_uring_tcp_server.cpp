@@ -0,0 +1,213 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#include "io_uring_tcp_server.h"
+
+namespace LL::Common {
+    IoUringTCPServer::~IoUringTCPServer() {
+        for (auto socket: connections_)
+            delete socket;
+        connections_.clear();
+        ready_sockets_.clear();
+    }
+
+    auto IoUringTCPServer::listen(const std::string &iface, int port) -> void {
+        ASSERT(listener_socket_.connect("", iface, port, true) >= 0,
+               "listener_socket_.connect() failed. iface:" + iface + " port:" +
+               std::to_string(port) + " error:" +
+               std::string(std::strerror(errno)));
+
+        ring_.prepAcceptMultishot(listener_socket_.socket_fd_, toUserData(&listener_socket_, Op::ACCEPT));
+        ASSERT(ring_.submit() >= 0, "io_uring_enter() failed. error:" + std::string(std::strerror(errno)));
+    }
+
+    auto IoUringTCPServer::poll() noexcept -> void {
+        ring_.submit();
+        ring_.forEachCqe([this](const io_uring_cqe &cqe) {
+            if (UNLIKELY(buffers_.onCompletion(cqe))) {
+                logger_.log("%:% %() % buffer refill failed error:% failures:%\n",
+                            __FILE__, __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_), -cqe.res, buffers_.provideFailures());
+                return;
+            }
+            auto socket = reinterpret_cast<TCPSocket *>(cqe.user_data & ~OpMask);
+            switch (static_cast<Op>(cqe.user_data & OpMask)) {
+                case Op::ACCEPT:
+                    onAccept(cqe);
+                    break;
+                case Op::RECV:
+                    onRecv(socket, cqe);
+                    break;
+                case Op::SEND:
+                    onSend(socket, cqe);
+                    break;
+                default:
+                    break;
+            }
+        });
+    }
+
+    auto IoUringTCPServer::sendAndRecv() noexcept -> void {
+        START_MEASURE(Common_IoUringTCPServer_sendAndRecv);
+        auto recv = false;
+
+        // Multishot receives carry no control messages, the rx time is when the first unread completion was reaped.
+
+        // Indexed loop, callbacks may append sockets they sent on to ready_sockets_.
+        for (size_t i = 0; i < ready_sockets_.size(); ++i) {
+            auto socket = ready_sockets_[i];
+            if (socket->recv_ready_) {
+                socket->recv_ready_ = false;
+                socket->recv_callback_(socket, socket->last_rx_time_);
+                recv = true;
+            }
+        }
+
+        if (recv)
+            recv_finished_callback_();
+
+        // One send in flight per socket, send_blocked_ doubles as the in-flight flag and the outbound bytes stay
+        // pinned until its completion.
+        size_t num_ready = 0;
+        for (size_t i = 0; i < ready_sockets_.size(); ++i) {
+            auto socket = ready_sockets_[i];
+            if (socket->hasPendingSend() && !socket->send_blocked_ && !socket->closed_) {
+                socket->send_blocked_ = true;
+                socket->outbound_data_.setPinned(true);
+                ring_.prepSend(socket->socket_fd_, socket->outbound_data_.data(), socket->outbound_data_.size(),
+                               toUserData(socket, Op::SEND));
+                ++pending_ops_[socket->socket_fd_];
+            }
+
+            if (socket->closed_ && !pending_ops_[socket->socket_fd_]) {
+                closeConnection(socket);
+            } else if (socket->closed_) {
+                // Ends the multishot receive and any send still in flight, their completions release the socket.
+                shutdown(socket->socket_fd_, SHUT_RDWR);
+                ready_sockets_[num_ready++] = socket;
+            } else if (socket->recv_ready_) {
+                ready_sockets_[num_ready++] = socket;
+            } else {
+                socket->in_ready_list_ = false;
+            }
+        }
+        ready_sockets_.resize(num_ready);
+
+        ring_.submit();
+
+        if (recv)
+            RECORD_MEASURE(Common_IoUringTCPServer_sendAndRecv, send_and_recv_latency_);
+    }
+
+    auto IoUringTCPServer::onAccept(const io_uring_cqe &cqe) noexcept -> void {
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+            ring_.prepAcceptMultishot(listener_socket_.socket_fd_, toUserData(&listener_socket_, Op::ACCEPT));
+
+        const auto fd = cqe.res;
+        if (fd < 0) {
+            logger_.log("%:% %() % accept failed error:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), -fd);
+            return;
+        }
+
+        ASSERT(disableNagle(fd), "disableNagle() failed. error:" + std::to_string(fd));
+
+        logger_.log("%:% %() % accepted socket:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), fd);
+
+        auto socket = new TCPSocket(logger_, socket_buffer_size_, metrics_prefix_ + "/TCPSocket");
+        socket->socket_fd_ = fd;
+        socket->recv_callback_ = recv_callback_;
+        socket->recv_ready_ = false;
+        socket->ready_list_ = &ready_sockets_;
+
+        if (static_cast<size_t>(fd) >= connections_.size()) {
+            const auto size = std::max<size_t>(fd + 1, connections_.size() * 2);
+            connections_.resize(size, nullptr);
+            pending_ops_.resize(size, 0);
+        }
+        connections_[fd] = socket;
+        ++num_connections_;
+
+        ring_.prepRecvMultishot(fd, buffers_.bufferGroup(), toUserData(socket, Op::RECV));
+        ++pending_ops_[fd];
+    }
+
+    auto IoUringTCPServer::onRecv(TCPSocket *socket, const io_uring_cqe &cqe) noexcept -> void {
+        const auto more = cqe.flags & IORING_CQE_F_MORE;
+        if (!more)
+            --pending_ops_[socket->socket_fd_];
+
+        if (cqe.res > 0) {
+            TTT_MEASURE(T1_OrderServer_TCP_read, logger_);
+            const auto bid = IoUringBufferPool::bufferId(cqe);
+            const auto len = static_cast<size_t>(cqe.res);
+
+            // A burst larger than the connection buffer is handed to the callback early to make room, a client
+            // that still does not fit is disconnected rather than silently truncated.
+            if (UNLIKELY(socket->inbound_data_.freeSpace() < len)) {
+                socket->recv_callback_(socket, socket->last_rx_time_);
+                socket->recv_ready_ = false;
+            }
+            if (!socket->recv_ready_)
+                socket->last_rx_time_ = getCurrentNanos();
+            if (LIKELY(socket->inbound_data_.append(buffers_.buffer(bid), len))) {
+                socket->recv_ready_ = true;
+            } else {
+                logger_.log("%:% %() % inbound buffer overflow socket:% len:% buffered:%\n",
+                            __FILE__, __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_), socket->socket_fd_, len, socket->inbound_data_.size());
+                socket->closed_ = true;
+            }
+            buffers_.recycle(bid);
+
+            logger_.log("%:% %() % read socket:% len:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), socket->socket_fd_, socket->inbound_data_.size());
+        } else if (cqe.res == 0 || cqe.res != -ENOBUFS) {
+            socket->closed_ = true;
+        }
+
+        // The kernel ends a multishot receive when it runs out of buffers, re-arm it unless the peer is gone.
+        if (!more && !socket->closed_) {
+            ring_.prepRecvMultishot(socket->socket_fd_, buffers_.bufferGroup(), toUserData(socket, Op::RECV));
+            ++pending_ops_[socket->socket_fd_];
+        }
+        socket->markReady();
+    }
+
+    auto IoUringTCPServer::onSend(TCPSocket *socket, const io_uring_cqe &cqe) noexcept -> void {
+        --pending_ops_[socket->socket_fd_];
+        socket->outbound_data_.setPinned(false);
+        socket->send_blocked_ = false;
+
+        if (cqe.res > 0) {
+            socket->outbound_data_.consume(cqe.res);
+            TTT_MEASURE(T6t_OrderServer_TCP_write, logger_);
+        } else {
+            socket->closed_ = true;
+        }
+        logger_.log("%:% %() % send socket:% len:% pending:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), socket->socket_fd_, cqe.res, socket->outbound_data_.size());
+
+        if (socket->hasPendingSend() || socket->closed_)
+            socket->markReady();
+    }
+
+    auto IoUringTCPServer::closeConnection(TCPSocket *socket) noexcept -> void {
+        logger_.log("%:% %() % closing socket:% pending_send:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), socket->socket_fd_, socket->outbound_data_.size());
+
+        if (disconnect_callback_)
+            disconnect_callback_(socket);
+
+        connections_[socket->socket_fd_] = nullptr;
+        --num_connections_;
+        delete socket;
+    }
+}
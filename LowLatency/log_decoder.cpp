@@ -0,0 +1,62 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#include <unordered_map>
+
+#include "logging.h"
+
+using namespace LL::Common;
+
+template<typename T>
+static auto readValue(std::istream &is, T *value) {
+    return static_cast<bool>(is.read(reinterpret_cast<char *>(value), sizeof(T)));
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "USAGE: log_decoder <binary log file>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    ASSERT(file.is_open(), "Could not open log file:" + std::string(argv[1]));
+
+    char magic[sizeof(LOG_BINARY_MAGIC)];
+    ASSERT(file.read(magic, sizeof(magic)) && !memcmp(magic, LOG_BINARY_MAGIC, sizeof(magic)),
+           "Not a binary log file:" + std::string(argv[1]));
+
+    std::unordered_map<uint32_t, std::string> formats;
+    std::string payload;
+    LogEntryKind kind;
+    while (readValue(file, &kind)) {
+        uint32_t format_id = 0;
+        uint32_t len = 0;
+        ASSERT(readValue(file, &format_id), "Truncated log entry.");
+        switch (kind) {
+            case LogEntryKind::FORMAT: {
+                ASSERT(readValue(file, &len), "Truncated format entry.");
+                std::string format(len, '\0');
+                ASSERT(static_cast<bool>(file.read(format.data(), len)), "Truncated format entry.");
+                formats[format_id] = std::move(format);
+            }
+            break;
+            case LogEntryKind::RECORD: {
+                uint64_t tsc = 0;
+                ASSERT(readValue(file, &tsc) && readValue(file, &len), "Truncated record entry.");
+                payload.resize(len);
+                ASSERT(static_cast<bool>(file.read(payload.data(), len)), "Truncated record entry.");
+
+                const auto format = formats.find(format_id);
+                ASSERT(format != formats.end(), "Unknown format id:" + std::to_string(format_id));
+                std::cout << tsc << " ";
+                formatLogRecord(std::cout, format->second.c_str(), payload.data(), payload.size());
+            }
+            break;
+            default:
+                FATAL("Unknown log entry kind:" + std::to_string(static_cast<int>(kind)));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,20 +1,22 @@
 #include "market_data_publisher.h"
 
 namespace LL::Exchange {
-    MarketDataPublisher::MarketDataPublisher(MEMarketUpdateLFQueue *market_updates, const std::string &iface,
+    MarketDataPublisher::MarketDataPublisher(MEMarketUpdateRing *market_updates, const std::string &iface,
                                              const std::string &snapshot_ip, int snapshot_port,
-                                             const std::string &incremental_ip, int incremental_port)
+                                             const std::string &incremental_ip, int incremental_port,
+                                             const InstrumentRegistry &instruments)
         : outgoing_md_updates_(market_updates),
-          snapshot_md_updates_(ME_MAX_MARKET_UPDATES),
+          md_consumer_id_(market_updates->addConsumer()),
           run_(false),
           logger_("exchange_market_data_publisher.log"),
-          incremental_socket_(logger_) {
+          incremental_socket_(logger_, McastMaxDatagramSize, "Exchange/MarketDataPublisher/incremental_socket"),
+          incremental_packetizer_(&incremental_socket_) {
         ASSERT(incremental_socket_.init(incremental_ip, iface,
-                                        incremental_port, false) >= 0,
+                                        incremental_port, false, true) >= 0,
                "Unable to create incremental mcast socket. error:"
                + std::string(std::strerror(errno)));
-        snapshot_synthesizer_ = new SnapshotSynthesizer(&snapshot_md_updates_,
-                                                        iface, snapshot_ip, snapshot_port);
+        snapshot_synthesizer_ = new SnapshotSynthesizer(outgoing_md_updates_,
+                                                        iface, snapshot_ip, snapshot_port, instruments);
     }
 
     MarketDataPublisher::~MarketDataPublisher() {
@@ -24,6 +26,8 @@ namespace LL::Exchange {
 
         delete snapshot_synthesizer_;
         snapshot_synthesizer_ = nullptr;
+
+        outgoing_md_updates_->removeConsumer(md_consumer_id_);
     }
 
     auto MarketDataPublisher::start() -> void {
@@ -40,31 +44,41 @@ namespace LL::Exchange {
         snapshot_synthesizer_->stop();
     }
 
+    auto MarketDataPublisher::setIdleStrategy(IdleStrategyType publisher_type,
+                                              IdleStrategyType snapshot_type) -> void {
+        idle_strategy_ = IdleStrategy(publisher_type,
+                                      publisher_type == IdleStrategyType::PARK
+                                          ? outgoing_md_updates_->getWakeSignal()
+                                          : nullptr);
+        snapshot_synthesizer_->setIdleStrategy(snapshot_type);
+    }
+
     auto MarketDataPublisher::run() noexcept -> void {
         logger_.log("%:% %() %\n",
                     __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_));
         while (run_) {
-            for (auto market_update = outgoing_md_updates_->getNextToRead();
-                 outgoing_md_updates_->size() &&
-                 market_update; market_update = outgoing_md_updates_->getNextToRead()) {
+            const auto num_updates = outgoing_md_updates_->peek(md_consumer_id_, outgoing_md_updates_->capacity());
+            for (size_t i = 0; i < num_updates; ++i) {
+                const auto market_update = outgoing_md_updates_->getReadSlot(md_consumer_id_, i);
+                TTT_MEASURE(T5_MarketDataPublisher_LFQueue_read, logger_);
                 logger_.log("%:% %() % Sending seq:% %\n",
                             __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_),
-                            next_inc_seq_num_, market_update->toString().c_str());
-
-                incremental_socket_.send(&next_inc_seq_num_, sizeof(next_inc_seq_num_));
-                incremental_socket_.send(market_update, sizeof(MEMarketUpdate));
-
-                outgoing_md_updates_->updateReadIndex();
+                            next_inc_seq_num_, *market_update);
 
-
-                auto next_write = snapshot_md_updates_.getNextToWriteTo();
-                next_write->seq_num_ = next_inc_seq_num_;
-                next_write->me_market_update_ = *market_update;
-                snapshot_md_updates_.updateWriteIndex();
+                incremental_packetizer_.add(next_inc_seq_num_, *market_update);
 
                 next_inc_seq_num_++;
             }
+            if (num_updates) {
+                outgoing_md_updates_->consume(md_consumer_id_, num_updates);
+                incremental_packetizer_.flush();
+            }
+
             incremental_socket_.sendAndRecv();
+            if (num_updates)
+                TTT_MEASURE(T6_MarketDataPublisher_UDP_write, logger_);
+
+            idle_strategy_.idle(num_updates);
         }
     }
 }
@@ -5,15 +5,46 @@
 #include "matching_engine.h"
 
 namespace LL::Exchange {
-    MatchingEngine::MatchingEngine(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses,
-                                   MEMarketUpdateLFQueue *market_updates)
-        : incoming_requests_(client_requests),
+    MatchingEngine::MatchingEngine(ClientResponseLFQueue *client_responses, MEMarketUpdateRing *market_updates,
+                                   const InstrumentRegistry &instruments, const std::string &name,
+                                   const std::string &log_file)
+        : name_(name),
+          instruments_(instruments),
+          books_(instruments.size()),
           outgoing_ogw_responses_(client_responses),
           outgoing_md_updates_(market_updates),
-          logger_("exchange_matching_engine.log") {
-        for (size_t i = 0; i < ticker_order_books_.size(); ++i) {
-            ticker_order_books_[i] = new MEOrderBook(i, &logger_, this);
-        }
+          logger_(log_file),
+          process_request_latency_(MetricsRegistry::instance().histogram("Exchange/" + name_ + "/process_request_ns")),
+          request_queue_depth_(MetricsRegistry::instance().histogram("Exchange/" + name_ + "/request_queue_depth")),
+          requests_processed_(MetricsRegistry::instance().counter("Exchange/" + name_ + "/requests")),
+          books_opened_(MetricsRegistry::instance().counter("Exchange/" + name_ + "/books_opened")),
+          books_released_(MetricsRegistry::instance().counter("Exchange/" + name_ + "/books_released")),
+          unknown_ticker_requests_(MetricsRegistry::instance().counter("Exchange/" + name_ + "/unknown_ticker")),
+          batch_latency_(MetricsRegistry::instance().histogram("Exchange/" + name_ + "/batch_ns")),
+          batch_responses_(MetricsRegistry::instance().histogram("Exchange/" + name_ + "/batch_responses")),
+          batch_market_updates_(MetricsRegistry::instance().histogram("Exchange/" + name_ + "/batch_market_updates")) {
+    }
+
+    MatchingEngine::MatchingEngine(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses,
+                                   MEMarketUpdateRing *market_updates, const InstrumentRegistry &instruments)
+        : MatchingEngine(client_responses, market_updates, instruments, "MatchingEngine",
+                         "exchange_matching_engine.log") {
+        incoming_requests_ = client_requests;
+    }
+
+    MatchingEngine::MatchingEngine(ClientRequestMPSCQueue *client_requests, ClientResponseLFQueue *client_responses,
+                                   MEMarketUpdateRing *market_updates, const InstrumentRegistry &instruments)
+        : MatchingEngine(client_responses, market_updates, instruments, "MatchingEngine",
+                         "exchange_matching_engine.log") {
+        incoming_gateway_requests_ = client_requests;
+    }
+
+    MatchingEngine::MatchingEngine(ClientRequestLFQueue *client_requests, ClientResponseLFQueue *client_responses,
+                                   MEMarketUpdateRing *market_updates, const InstrumentRegistry &instruments,
+                                   size_t shard)
+        : MatchingEngine(client_responses, market_updates, instruments, "MatchingEngine/" + std::to_string(shard),
+                         "exchange_matching_engine_" + std::to_string(shard) + ".log") {
+        incoming_requests_ = client_requests;
     }
 
     MatchingEngine::~MatchingEngine() {
@@ -23,19 +54,20 @@ namespace LL::Exchange {
         std::this_thread::sleep_for(1s);
 
         incoming_requests_ = nullptr;
+        incoming_gateway_requests_ = nullptr;
         outgoing_ogw_responses_ = nullptr;
         outgoing_md_updates_ = nullptr;
 
-        for (auto &order_book: ticker_order_books_) {
-            delete order_book;
-            order_book = nullptr;
+        for (auto &slot: books_) {
+            delete slot.book_;
+            slot.book_ = nullptr;
         }
     }
 
     auto MatchingEngine::start() -> void {
         run_ = true;
         ASSERT(createAndStartThread(-1,
-                                    "Exchange/MatchingEngine",
+                                    "Exchange/" + name_,
                                     [this]() {
                                         run();
                                     }) != nullptr, "Failed to start MatchingEngine::start()");
@@ -44,4 +76,112 @@ namespace LL::Exchange {
     auto MatchingEngine::stop() -> void {
         run_ = false;
     }
+
+    auto MatchingEngine::setIdleStrategy(IdleStrategyType type) -> void {
+        WakeSignal *wake_signal = nullptr;
+        if (type == IdleStrategyType::PARK)
+            wake_signal = incoming_requests_
+                              ? incoming_requests_->getWakeSignal()
+                              : incoming_gateway_requests_->getWakeSignal();
+        idle_strategy_ = IdleStrategy(type, wake_signal);
+    }
+
+    auto MatchingEngine::setBatchSize(size_t batch_size) -> void {
+        batch_size_ = batch_size;
+    }
+
+    // Reserving more of the queue fails only once it is full, the outputs so far are then published so the consumer
+    // can make room, and like the unbatched path a full response queue is fatal while the market update ring waits.
+    auto MatchingEngine::reserveResponses() noexcept -> void {
+        const auto chunk = batch_size_ * ME_BATCH_OUTPUTS_PER_REQUEST;
+        reserved_responses_ = outgoing_ogw_responses_->reserve(pending_responses_ + chunk);
+        if (reserved_responses_ > pending_responses_)
+            return;
+
+        outgoing_ogw_responses_->publish(pending_responses_);
+        batch_responses_flushed_ += pending_responses_;
+        pending_responses_ = 0;
+        reserved_responses_ = outgoing_ogw_responses_->reserve(chunk);
+        if (UNLIKELY(!reserved_responses_))
+            FATAL("SPSCQueue full, capacity:" + std::to_string(outgoing_ogw_responses_->capacity()));
+    }
+
+    auto MatchingEngine::reserveMarketUpdates() noexcept -> void {
+        const auto chunk = batch_size_ * ME_BATCH_OUTPUTS_PER_REQUEST;
+        reserved_market_updates_ = outgoing_md_updates_->reserve(pending_market_updates_ + chunk);
+        if (reserved_market_updates_ > pending_market_updates_)
+            return;
+
+        outgoing_md_updates_->publish(pending_market_updates_);
+        batch_market_updates_flushed_ += pending_market_updates_;
+        pending_market_updates_ = 0;
+        while (!(reserved_market_updates_ = outgoing_md_updates_->reserve(chunk)));
+    }
+
+    auto MatchingEngine::publishBatch() noexcept -> void {
+        if (pending_responses_)
+            outgoing_ogw_responses_->publish(pending_responses_);
+        if (pending_market_updates_)
+            outgoing_md_updates_->publish(pending_market_updates_);
+        pending_responses_ = reserved_responses_ = batch_responses_flushed_ = 0;
+        pending_market_updates_ = reserved_market_updates_ = batch_market_updates_flushed_ = 0;
+    }
+
+    auto MatchingEngine::openOrderBook(const MEClientRequest *client_request) noexcept -> MEOrderBook * {
+        const auto instrument = instruments_.find(client_request->ticker_id_);
+        if (UNLIKELY(!instrument)) {
+            logger_.log("%:% %() % Dropping request for unknown ticker %\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), *client_request);
+            unknown_ticker_requests_->add();
+            return nullptr;
+        }
+
+        // Nothing can rest on a ticker without a book.
+        if (client_request->type_ == ClientRequestType::CANCEL) {
+            client_response_ = {
+                ClientResponseType::CANCEL_REJECTED,
+                client_request->client_id_, client_request->ticker_id_, client_request->order_id_, OrderId_INVALID,
+                Side::INVALID, Price_INVALID, Quantity_INVALID, Quantity_INVALID
+            };
+            sendClientResponse(&client_response_);
+            return nullptr;
+        }
+
+        auto &slot = books_[instrument->ticker_id_];
+        slot.book_ = new MEOrderBook(*instrument, &logger_, this, slot.next_market_order_id_);
+        ++num_open_books_;
+        books_opened_->add();
+        logger_.log("%:% %() % Opened book % open books:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), instrument->toString(), num_open_books_);
+        return slot.book_;
+    }
+
+    // Releases books that were empty at the previous check and have seen no request since. Checks are at least
+    // ME_BOOK_RELEASE_DELAY apart.
+    auto MatchingEngine::releaseIdleOrderBooks() noexcept -> void {
+        requests_since_release_check_ = 0;
+        if (!num_open_books_)
+            return;
+        const auto now = getCurrentNanos();
+        if (now - last_release_check_time_ < ME_BOOK_RELEASE_DELAY)
+            return;
+        last_release_check_time_ = now;
+
+        for (auto &slot: books_) {
+            if (!slot.book_)
+                continue;
+            const auto idle = slot.requests_ == slot.requests_at_release_check_;
+            slot.requests_at_release_check_ = slot.requests_;
+            if (!idle || !slot.book_->empty())
+                continue;
+
+            slot.next_market_order_id_ = slot.book_->nextMarketOrderId();
+            delete slot.book_;
+            slot.book_ = nullptr;
+            --num_open_books_;
+            books_released_->add();
+        }
+    }
 }
@@ -4,12 +4,31 @@
 #include "mcast_socket.h"
 
 namespace LL::Common {
-    auto McastSocket::init(const std::string &ip, const std::string &iface, int port, bool is_listening) -> int {
-        const SocketCfg socket_cfg{ip, iface, port, true, is_listening, false};
+    auto McastSocket::init(const std::string &ip, const std::string &iface, int port, bool is_listening,
+                           bool tx_timestamps) -> int {
+        const SocketCfg socket_cfg{ip, iface, port, true, is_listening, true, tx_timestamps};
         socket_fd_ = createSocket(logger_, socket_cfg);
+        tx_timestamps_ = tx_timestamps;
+        ip_ = ip;
+        port_ = port;
         return socket_fd_;
     }
 
+    auto McastSocket::recordTxSends(size_t n, Nanos send_time) noexcept -> void {
+        for (size_t i = 0; tx_timestamps_ && i < n; ++i)
+            tx_send_times_[tx_next_id_++ % tx_send_times_.size()] = send_time;
+    }
+
+    auto McastSocket::readTxTimestamps() noexcept -> void {
+        uint32_t tx_id = 0;
+        Nanos tx_time = 0;
+        for (size_t i = 0; i < McastRecvBatch && readTxTimestamp(socket_fd_, &tx_id, &tx_time); ++i) {
+            const auto send_time = tx_send_times_[tx_id % tx_send_times_.size()];
+            if (tx_time && send_time && tx_time >= send_time)
+                send_to_wire_latency_->record(tx_time - send_time);
+        }
+    }
+
     auto McastSocket::join(const std::string &ip) -> bool {
         return Common::join(socket_fd_, ip);
     }
@@ -19,36 +38,257 @@ namespace LL::Common {
         socket_fd_ = -1;
     }
 
-    auto McastSocket::sendAndRecv() noexcept -> bool {
-        const ssize_t n_rcv = recv(socket_fd_, inbound_data_.data() + next_recv_valid_index_,
-                                   McastBufferSize - next_recv_valid_index_, MSG_DONTWAIT);
-        if (n_rcv > 0) {
-            next_recv_valid_index_ += n_rcv;
-            logger_.log("%:% %() % read socket:% len:%\n",
+    auto McastSocket::endDatagram() noexcept -> void {
+        if (!outbound_lens_[num_datagrams_])
+            return;
+        ++num_datagrams_;
+        outbound_lens_[num_datagrams_] = 0;
+
+        // Out of slots, the sender fell behind sendAndRecv() calls, wait for the kernel to take what we have.
+        if (UNLIKELY(num_datagrams_ == McastMaxDatagrams)) {
+            logger_.log("%:% %() % datagram slots full socket:%\n",
                         __FILE__, __LINE__, __FUNCTION__,
-                        getCurrentTimeStr(&time_str_), socket_fd_, next_recv_valid_index_);
-            recv_callback_(this);
+                        getCurrentTimeStr(&time_str_), socket_fd_);
+            sendDatagrams(true);
+
+            // A hard send error leaves the slots full, drop the oldest datagrams so the next write has a slot.
+            if (UNLIKELY(num_datagrams_ == McastMaxDatagrams)) {
+                dropped_datagrams_ += num_datagrams_;
+                logger_.log("%:% %() % send failed socket:% error:% dropped datagrams:% total dropped:%\n",
+                            __FILE__, __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_), socket_fd_, std::strerror(errno), num_datagrams_,
+                            dropped_datagrams_);
+                dropDatagrams(num_datagrams_);
+            }
         }
+    }
 
-        if (next_send_valid_index_ > 0) {
-            const ssize_t n = ::send(socket_fd_,
-                                     outbound_data_.data(),
-                                     next_send_valid_index_, MSG_DONTWAIT | MSG_NOSIGNAL);
+    auto McastSocket::send(const void *data, size_t len) noexcept -> void {
+        memcpy(reserve(len), data, len);
+        commit(len);
+    }
 
+    // Removes the first n datagrams and moves the rest, including the open one, to the front.
+    auto McastSocket::dropDatagrams(size_t n) noexcept -> void {
+        for (size_t i = n; i <= num_datagrams_; ++i) {
+            memmove(outbound_data_.data() + (i - n) * max_datagram_size_,
+                    outbound_data_.data() + i * max_datagram_size_, outbound_lens_[i]);
+            outbound_lens_[i - n] = outbound_lens_[i];
+        }
+        num_datagrams_ -= n;
+    }
+
+    auto McastSocket::sendDatagrams(bool block) noexcept -> void {
+        if (io_uring_) {
+            const auto first = inflight_datagrams_;
+            for (size_t i = first; i < num_datagrams_; ++i)
+                io_uring_->prepSend(socket_fd_, outbound_data_.data() + i * max_datagram_size_, outbound_lens_[i],
+                                    McastIoUringSend);
+            recordTxSends(num_datagrams_ - first, getCurrentNanos());
+            inflight_datagrams_ = num_datagrams_;
+            io_uring_->submit();
+            while (block && inflight_datagrams_) {
+                io_uring_->submit(1);
+                reapIoUring();
+            }
+            return;
+        }
 
-            logger_.log("%:% %() % send socket:% len:%\n",
+        size_t sent = 0;
+        while (sent < num_datagrams_) {
+            const auto n = std::min(num_datagrams_ - sent, send_msgs_.size());
+            for (size_t i = 0; i < n; ++i) {
+                send_iovs_[i] = {outbound_data_.data() + (sent + i) * max_datagram_size_, outbound_lens_[sent + i]};
+                send_msgs_[i] = {};
+                send_msgs_[i].msg_hdr.msg_iov = &send_iovs_[i];
+                send_msgs_[i].msg_hdr.msg_iovlen = 1;
+            }
+            const auto send_time = getCurrentNanos();
+            const auto rc = sendmmsg(socket_fd_, send_msgs_.data(), n, MSG_DONTWAIT | MSG_NOSIGNAL);
+            logger_.log("%:% %() % send socket:% datagrams:% sent:%\n",
                         __FILE__, __LINE__, __FUNCTION__,
-                        getCurrentTimeStr(&time_str_), socket_fd_, n);
+                        getCurrentTimeStr(&time_str_), socket_fd_, n, rc);
+            if (rc > 0) {
+                sent += rc;
+                recordTxSends(rc, send_time);
+            } else if (!block || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                break;
+            }
+        }
+        dropDatagrams(sent);
+    }
+
+    auto McastSocket::recvDatagrams() noexcept -> bool {
+        // Each datagram gets a full slot to land in, then they are packed back to back.
+        const auto n = std::min(McastRecvBatch, (inbound_data_.size() - next_recv_valid_index_) / max_datagram_size_);
+        if (UNLIKELY(!n))
+            return false;
+        for (size_t i = 0; i < n; ++i) {
+            recv_iovs_[i] = {inbound_data_.data() + next_recv_valid_index_ + i * max_datagram_size_, max_datagram_size_};
+            recv_msgs_[i] = {};
+            recv_msgs_[i].msg_hdr.msg_iov = &recv_iovs_[i];
+            recv_msgs_[i].msg_hdr.msg_iovlen = 1;
+            recv_msgs_[i].msg_hdr.msg_control = recv_ctrls_.data() + i * TimestampCtrlSize;
+            recv_msgs_[i].msg_hdr.msg_controllen = TimestampCtrlSize;
         }
-        next_send_valid_index_ = 0;
 
-        return n_rcv > 0;
+        const auto rc = recvmmsg(socket_fd_, recv_msgs_.data(), n, MSG_DONTWAIT, nullptr);
+        if (rc <= 0)
+            return false;
+
+        const auto user_time = getCurrentNanos();
+        for (int i = 0; i < rc; ++i) {
+            const auto kernel_time = getKernelTimestamp(&recv_msgs_[i].msg_hdr);
+            if (LIKELY(kernel_time && user_time >= kernel_time))
+                kernel_to_user_latency_->record(user_time - kernel_time);
+            const auto rx_time = kernel_time ? kernel_time : user_time;
+            const auto len = recv_msgs_[i].msg_len;
+            if (recv_datagram_callback_) {
+                recv_datagram_callback_(this, static_cast<const char *>(recv_iovs_[i].iov_base), len, rx_time);
+                continue;
+            }
+
+            if (!i)
+                rx_time_ = rx_time;
+            memmove(inbound_data_.data() + next_recv_valid_index_, recv_iovs_[i].iov_base, len);
+            next_recv_valid_index_ += len;
+        }
+        logger_.log("%:% %() % read socket:% datagrams:% len:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), socket_fd_, rc, next_recv_valid_index_);
+        return true;
     }
 
-    auto McastSocket::send(const void *data, size_t len) noexcept -> void {
-        memcpy(outbound_data_.data() + next_send_valid_index_, data, len);
-        next_send_valid_index_ += len;
-        ASSERT(next_send_valid_index_ < McastBufferSize,
-               "Mcast socket buffer fulled up and sendAndRecv() not called.");
+    auto McastSocket::enableXdp(const std::string &iface, int queue_id) -> bool {
+        ASSERT(socket_fd_ >= 0, "enableXdp() called before init().");
+        // The io_uring receive sits on the kernel socket, which the XDP program would starve.
+        if (io_uring_) {
+            logger_.log("%:% %() % AF_XDP not available on io_uring socket:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), socket_fd_);
+            return false;
+        }
+        auto xdp = std::make_unique<XdpSocket>(logger_);
+        if (!xdp->init(iface, queue_id, ip_, port_))
+            return false;
+        xdp_ = std::move(xdp);
+        return true;
+    }
+
+    auto McastSocket::recvXdp() noexcept -> bool {
+        const auto user_time = getCurrentNanos();
+        rx_time_ = user_time;
+        auto copied = false;
+        const auto n = xdp_->recv([&](const char *data, size_t len) {
+            if (recv_datagram_callback_) {
+                recv_datagram_callback_(this, data, len, user_time);
+            } else if (LIKELY(next_recv_valid_index_ + len <= inbound_data_.size())) {
+                memcpy(inbound_data_.data() + next_recv_valid_index_, data, len);
+                next_recv_valid_index_ += len;
+                copied = true;
+            } else {
+                logger_.log("%:% %() % inbound buffer full, dropped datagram len:%\n",
+                            __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_), len);
+            }
+        });
+        if (n)
+            logger_.log("%:% %() % xdp read datagrams:% len:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), n, next_recv_valid_index_);
+        if (copied)
+            recv_callback_(this, rx_time_);
+        return n;
+    }
+
+    auto McastSocket::enableIoUring(unsigned ring_entries, bool sqpoll, int sqpoll_cpu) -> void {
+        ASSERT(socket_fd_ >= 0, "enableIoUring() called before init().");
+        ASSERT(!xdp_, "enableIoUring() called on a socket receiving through AF_XDP.");
+        io_uring_ = std::make_unique<IoUring>(ring_entries, sqpoll, sqpoll_cpu);
+        io_uring_buffers_ = std::make_unique<IoUringBufferPool>(*io_uring_, 0);
+        io_uring_->prepRecvMultishot(socket_fd_, io_uring_buffers_->bufferGroup(), McastIoUringRecv);
+        ASSERT(io_uring_->submit() >= 0, "io_uring_enter() failed. error:" + std::string(std::strerror(errno)));
+    }
+
+    auto McastSocket::reapIoUring() noexcept -> bool {
+        auto received = false;
+        io_uring_->forEachCqe([&](const io_uring_cqe &cqe) {
+            if (UNLIKELY(io_uring_buffers_->onCompletion(cqe))) {
+                logger_.log("%:% %() % buffer refill failed socket:% error:% failures:%\n",
+                            __FILE__, __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_), socket_fd_, -cqe.res, io_uring_buffers_->provideFailures());
+            } else if (cqe.user_data == McastIoUringRecv) {
+                if (cqe.res > 0) {
+                    const auto bid = IoUringBufferPool::bufferId(cqe);
+                    if (!received)
+                        rx_time_ = getCurrentNanos();
+                    if (recv_datagram_callback_) {
+                        recv_datagram_callback_(this, io_uring_buffers_->buffer(bid), cqe.res, rx_time_);
+                    } else {
+                        ASSERT(next_recv_valid_index_ + cqe.res <= inbound_data_.size(),
+                               "Mcast socket buffer fulled up and recv_callback_ not consuming.");
+                        memcpy(inbound_data_.data() + next_recv_valid_index_, io_uring_buffers_->buffer(bid), cqe.res);
+                        next_recv_valid_index_ += cqe.res;
+                    }
+                    io_uring_buffers_->recycle(bid);
+                    received = true;
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE) && socket_fd_ >= 0)
+                    io_uring_->prepRecvMultishot(socket_fd_, io_uring_buffers_->bufferGroup(), McastIoUringRecv);
+            } else if (cqe.user_data == McastIoUringSend) {
+                if (cqe.res < 0)
+                    logger_.log("%:% %() % send failed socket:% error:%\n",
+                                __FILE__, __LINE__, __FUNCTION__,
+                                getCurrentTimeStr(&time_str_), socket_fd_, -cqe.res);
+                // The slots are reused once the whole batch is out.
+                if (++completed_datagrams_ == inflight_datagrams_) {
+                    dropDatagrams(inflight_datagrams_);
+                    inflight_datagrams_ = completed_datagrams_ = 0;
+                }
+            }
+        });
+        return received;
+    }
+
+    auto McastSocket::sendAndRecvIoUring() noexcept -> bool {
+        const auto received = reapIoUring();
+        if (received && !recv_datagram_callback_) {
+            logger_.log("%:% %() % read socket:% len:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), socket_fd_, next_recv_valid_index_);
+            recv_callback_(this, rx_time_);
+        }
+
+        if (tx_timestamps_)
+            readTxTimestamps();
+        endDatagram();
+        if (!inflight_datagrams_ && num_datagrams_)
+            sendDatagrams(false);
+        else
+            io_uring_->submit();
+
+        return received;
+    }
+
+    auto McastSocket::sendAndRecv() noexcept -> bool {
+        if (io_uring_)
+            return sendAndRecvIoUring();
+
+        auto received = false;
+        if (xdp_) {
+            received = recvXdp();
+        } else {
+            received = recvDatagrams();
+            if (received && !recv_datagram_callback_)
+                recv_callback_(this, rx_time_);
+        }
+
+        if (tx_timestamps_)
+            readTxTimestamps();
+
+        endDatagram();
+        if (num_datagrams_)
+            sendDatagrams(false);
+
+        return received;
     }
 }
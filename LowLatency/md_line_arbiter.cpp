@@ -0,0 +1,131 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+#include "md_line_arbiter.h"
+
+namespace LL::Exchange {
+    MDLineArbiter::MDLineArbiter(McastSocket *line_a, McastSocket *line_b,
+                                 std::function<void(const MDPMarketUpdate &update)> update_callback,
+                                 Nanos gap_timeout, const std::string &metrics_prefix)
+        : lines_{line_a, line_b}, update_callback_(std::move(update_callback)), gap_timeout_(gap_timeout),
+          window_(MDArbiterWindow) {
+        auto &registry = MetricsRegistry::instance();
+        for (const auto line: {MDLine::A, MDLine::B}) {
+            const auto prefix = metrics_prefix + "/" + mdLineToString(line) + "/";
+            auto &stats = stats_[static_cast<size_t>(line)];
+            stats.updates_ = registry.counter(prefix + "updates");
+            stats.firsts_ = registry.counter(prefix + "firsts");
+            stats.duplicates_ = registry.counter(prefix + "duplicates");
+            stats.gaps_ = registry.counter(prefix + "gaps");
+            stats.lag_ = registry.histogram(prefix + "lag_ns");
+
+            lines_[static_cast<size_t>(line)]->recv_datagram_callback_ =
+                    [this, line](McastSocket *, const char *data, size_t len, Nanos rx_time) {
+                        onDatagram(line, data, len, rx_time);
+                    };
+        }
+        skipped_ = registry.counter(metrics_prefix + "/skipped");
+    }
+
+    auto MDLineArbiter::sendAndRecv() noexcept -> bool {
+        auto received = lines_[0]->sendAndRecv();
+        received |= lines_[1]->sendAndRecv();
+
+        if (UNLIKELY(num_pending_)) {
+            const auto now = getCurrentNanos();
+            if (now - gap_start_time_ >= gap_timeout_)
+                skipGap();
+        }
+        return received;
+    }
+
+    // Every datagram carries whole packets, so it is parsed on its own with its own receive stamp.
+    auto MDLineArbiter::onDatagram(MDLine line, const char *data, size_t len, Nanos rx_time) noexcept -> void {
+        parseMDPackets(data, len, [&](const MDPMarketUpdate &update) {
+            onUpdate(line, update, rx_time);
+        });
+    }
+
+    auto MDLineArbiter::onUpdate(MDLine line, const MDPMarketUpdate &update, Nanos rx_time) noexcept -> void {
+        auto &stats = stats_[static_cast<size_t>(line)];
+        stats.updates_->add();
+
+        const auto seq_num = update.seq_num_;
+        auto &line_next_seq_num = line_next_seq_num_[static_cast<size_t>(line)];
+        if (line_next_seq_num && seq_num > line_next_seq_num)
+            stats.gaps_->add(seq_num - line_next_seq_num);
+        if (seq_num >= line_next_seq_num)
+            line_next_seq_num = seq_num + 1;
+
+        if (UNLIKELY(!next_seq_num_))
+            next_seq_num_ = seq_num;
+
+        auto &slot = window_[seq_num % MDArbiterWindow];
+        if (seq_num < next_seq_num_ || (slot.pending_ && slot.seq_num_ == seq_num)) {
+            stats.duplicates_->add();
+            // The receive stamps can order the copies differently from the order we read the lines in.
+            if (slot.seq_num_ == seq_num && slot.line_ != line) {
+                if (rx_time >= slot.rx_time_)
+                    stats.lag_->record(rx_time - slot.rx_time_);
+                else
+                    stats_[static_cast<size_t>(slot.line_)].lag_->record(slot.rx_time_ - rx_time);
+            }
+            return;
+        }
+
+        // Too far ahead to hold, give up on everything still missing before it.
+        while (UNLIKELY(seq_num >= next_seq_num_ + MDArbiterWindow)) {
+            if (num_pending_) {
+                skipGap();
+            } else {
+                skipped_->add(seq_num - next_seq_num_);
+                if (gap_callback_)
+                    gap_callback_(next_seq_num_, seq_num - 1);
+                next_seq_num_ = seq_num;
+            }
+        }
+
+        stats.firsts_->add();
+        slot = {seq_num, rx_time, line, seq_num != next_seq_num_, update.me_market_update_};
+        if (seq_num != next_seq_num_) {
+            // Timed on our own clock like the check in sendAndRecv(), rx_time can be a kernel stamp.
+            if (!num_pending_++)
+                gap_start_time_ = getCurrentNanos();
+            return;
+        }
+
+        forward(seq_num, update.me_market_update_);
+        drainPending();
+    }
+
+    auto MDLineArbiter::forward(size_t seq_num, const MEMarketUpdate &update) noexcept -> void {
+        update_callback_({seq_num, update});
+        next_seq_num_ = seq_num + 1;
+    }
+
+    auto MDLineArbiter::drainPending() noexcept -> void {
+        while (num_pending_) {
+            auto &slot = window_[next_seq_num_ % MDArbiterWindow];
+            if (!slot.pending_ || slot.seq_num_ != next_seq_num_)
+                break;
+            slot.pending_ = false;
+            --num_pending_;
+            forward(next_seq_num_, slot.update_);
+        }
+        if (num_pending_)
+            gap_start_time_ = getCurrentNanos();
+    }
+
+    // Jumps over the missing sequence numbers up to the oldest held update and forwards what follows it.
+    auto MDLineArbiter::skipGap() noexcept -> void {
+        auto seq_num = next_seq_num_;
+        while (!window_[seq_num % MDArbiterWindow].pending_ || window_[seq_num % MDArbiterWindow].seq_num_ != seq_num)
+            ++seq_num;
+
+        skipped_->add(seq_num - next_seq_num_);
+        if (gap_callback_)
+            gap_callback_(next_seq_num_, seq_num - 1);
+        next_seq_num_ = seq_num;
+        drainPending();
+    }
+}
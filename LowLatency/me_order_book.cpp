@@ -8,22 +8,30 @@
 
 
 namespace LL::Exchange {
-    MEOrderBook::MEOrderBook(TickerId ticker_id, Logger *logger, MatchingEngine *matching_engine)
-        : ticker_id_(ticker_id),
-          matching_engine_(matching_engine), orders_at_price_pool_(ME_MAX_PRICE_LEVELS),
-          order_pool_(ME_MAX_ORDER_IDS),
+    MEOrderBook::MEOrderBook(const InstrumentCfg &instrument, Logger *logger, MatchingEngine *matching_engine,
+                             OrderId next_market_order_id)
+        : ticker_id_(instrument.ticker_id_),
+          matching_engine_(matching_engine), orders_at_price_pool_(instrument.max_price_levels_),
+          price_ladder_(instrument.price_ladder_levels_, instrument.max_price_levels_),
+          order_block_pool_(instrument),
+          order_pool_(instrument.max_orders_, instrument.max_orders_ * sizeof(MEOrder) >= HUGE_PAGE_SIZE),
+          next_market_order_id_(next_market_order_id),
           logger_(logger) {
     }
 
     MEOrderBook::~MEOrderBook() {
-        logger_->log("%%:% %() % OrderBook\n%\n",
+        logger_->log("%:% %() % OrderBook\n%\n",
                      __FILE__, __LINE__, __FUNCTION__,
                      getCurrentTimeStr(&time_str_),
                      toString(true, false));
+        logger_->log("%:% %() % OrderBook pools orders live:% hwm:% hugepages:% levels live:% hwm:% records carved:% of %\n",
+                     __FILE__, __LINE__, __FUNCTION__,
+                     getCurrentTimeStr(&time_str_),
+                     order_pool_.liveCount(), order_pool_.highWaterMark(), order_pool_.usingHugePages(),
+                     orders_at_price_pool_.liveCount(), orders_at_price_pool_.highWaterMark(),
+                     order_block_pool_.carved(), order_block_pool_.capacity());
         matching_engine_ = nullptr;
-        bids_by_price_ = asks_by_price_ = nullptr;
-        for (auto &itr: cid_oid_to_order_)
-            itr.fill(nullptr);
+        cid_oid_to_order_.clear();
     }
 
     auto MEOrderBook::add(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side, Price price,
@@ -38,12 +46,8 @@ namespace LL::Exchange {
         const auto leaves_qty = checkForMatch(client_id,
                                               client_order_id, ticker_id, side, price, qty, new_market_order_id);
         if (LIKELY(leaves_qty)) {
-            const auto priority = getNextPriority(price);
-
-            auto order = order_pool_.allocate(ticker_id, client_id, client_order_id,
-                                              new_market_order_id, side, price, leaves_qty, priority, nullptr,
-                                              nullptr);
-            addOrder(order);
+            const auto priority = addOrder(ticker_id, side, price,
+                                           {client_order_id, new_market_order_id, leaves_qty, client_id});
 
             market_update_ = {MarketUpdateType::ADD, new_market_order_id, ticker_id, side, price, leaves_qty, priority};
             matching_engine_->sendMarketUpdate(&market_update_);
@@ -51,14 +55,8 @@ namespace LL::Exchange {
     }
 
     auto MEOrderBook::cancel(ClientId client_id, OrderId order_id, TickerId ticker_id) noexcept -> void {
-        auto is_cancelable = (client_id < cid_oid_to_order_.size());
-
-        MEOrder *exchange_order = nullptr;
-        if (LIKELY(is_cancelable)) {
-            auto &co_itr = cid_oid_to_order_.at(client_id);
-            exchange_order = co_itr.at(order_id);
-            is_cancelable = (exchange_order != nullptr);
-        }
+        auto exchange_order = cid_oid_to_order_.find(client_id, order_id);
+        const auto is_cancelable = (exchange_order != nullptr);
 
         if (UNLIKELY(!is_cancelable)) {
             client_response_ = {
@@ -67,16 +65,17 @@ namespace LL::Exchange {
                 Side::INVALID, Price_INVALID, Quantity_INVALID, Quantity_INVALID
             };
         } else {
+            const auto &record = recordOf(exchange_order);
             client_response_ = {
                 ClientResponseType::CANCELED,
-                client_id, ticker_id, order_id, exchange_order->market_order_id_,
+                client_id, ticker_id, order_id, record.market_order_id_,
                 exchange_order->side_, exchange_order->price_, Quantity_INVALID,
-                exchange_order->quantity_
+                record.quantity_
             };
 
             market_update_ = {
                 MarketUpdateType::CANCEL,
-                exchange_order->market_order_id_, ticker_id, exchange_order->side_,
+                record.market_order_id_, ticker_id, exchange_order->side_,
                 exchange_order->price_, 0, exchange_order->priority_
             };
 
@@ -97,32 +96,27 @@ namespace LL::Exchange {
             Quantity qty = 0;
             size_t num_orders{0};
 
-            for (auto o_itr = itr->first_me_order_;; o_itr = o_itr->next_order_) {
-                qty += o_itr->quantity_;
-                ++num_orders;
-                if (o_itr->next_order_ == itr->first_me_order_) break;
+            const auto orders = itr->orders_;
+            for (auto i = itr->head_; i < itr->tail_; ++i) {
+                qty += orders[i].quantity_;
+                num_orders += !!orders[i].quantity_;
             }
 
-            sprintf(buf, " ,px:%3s p:%3s n:%3s> %-3s @ %-5s(%-4s)",
+            const auto next_itr = price_ladder_.next(side, itr->price_);
+            sprintf(buf, " ,px:%3s n:%3s> %-3s @ %-5s(%-4s)",
+                    priceToString(itr->price_).c_str(),
+                    priceToString(next_itr ? next_itr->price_ : Price_INVALID).c_str(),
                     priceToString(itr->price_).c_str(),
-                    priceToString(itr->prev_entry_->price_).c_str(),
-                    priceToString(itr->next_entry_->price_).c_str(), priceToString(itr->price_).c_str(),
                     quantityToString(qty).c_str(), std::to_string(num_orders).c_str());
             ss << buf;
 
-            for (auto o_itr = itr->first_me_order_;; o_itr = o_itr->next_order_) {
-                if (detailed) {
-                    sprintf(buf, "[oid:%s q:%s p:%s n:%s] ",
-                            orderIdToString(o_itr->market_order_id_).c_str(),
-                            quantityToString(o_itr->quantity_).c_str(),
-                            orderIdToString(o_itr->prev_order_ ? o_itr->prev_order_->market_order_id_ : OrderId_INVALID)
-                            .c_str(),
-                            orderIdToString(o_itr->next_order_ ? o_itr->next_order_->market_order_id_ : OrderId_INVALID)
-                            .c_str()
-                    );
-                    ss << buf;
-                }
-                if (o_itr->next_order_ == itr->first_me_order_) break;
+            for (auto i = itr->head_; detailed && i < itr->tail_; ++i) {
+                if (!orders[i].quantity_)
+                    continue;
+                sprintf(buf, "[oid:%s q:%s s:%u] ",
+                        orderIdToString(orders[i].market_order_id_).c_str(),
+                        quantityToString(orders[i].quantity_).c_str(), i);
+                ss << buf;
             }
 
             ss << std::endl;
@@ -138,93 +132,103 @@ namespace LL::Exchange {
         };
 
         ss << "Ticker: " << tickerIdToString(ticker_id_) << std::endl; {
-            auto ask_itr = asks_by_price_;
+            auto ask_itr = price_ladder_.best(Side::SELL);
             auto last_ask_price = std::numeric_limits<Price>::min();
             for (size_t count = 0; ask_itr; ++count) {
                 ss << "ASKS L:" << count << " => ";
-                auto next_ask_itr = (ask_itr->next_entry_ == asks_by_price_ ? nullptr : ask_itr->next_entry_);
                 printer(ss, ask_itr, Side::SELL, last_ask_price, validity_check);
-                ask_itr = next_ask_itr;
+                ask_itr = price_ladder_.next(Side::SELL, ask_itr->price_);
             }
         }
 
         ss << std::endl << "                     X " << std::endl << std::endl; {
-            auto bid_itr = bids_by_price_;
+            auto bid_itr = price_ladder_.best(Side::BUY);
             auto last_bid_price = std::numeric_limits<Price>::max();
             for (size_t count = 0; bid_itr; ++count) {
                 ss << "BIDS L:" << count << " => ";
-                auto next_bid_itr = (bid_itr->next_entry_ == bids_by_price_ ? nullptr : bid_itr->next_entry_);
                 printer(ss, bid_itr, Side::BUY, last_bid_price, validity_check);
-                bid_itr = next_bid_itr;
+                bid_itr = price_ladder_.next(Side::BUY, bid_itr->price_);
             }
         }
 
         return ss.str();
     }
 
+    // Fills against the level's orders in time priority until leaves_qty runs out or the level is swept. The
+    // records are contiguous, so a sweep through several resting orders reads memory front to back.
     auto MEOrderBook::match(TickerId ticker_id, ClientId client_id, Side side, OrderId client_order_id,
-                            OrderId new_market_order_id, MEOrder *bid_itr, Quantity *leaves_qty) noexcept {
-        const auto order = bid_itr;
-        const auto order_qty = order->quantity_;
-        const auto fill_qty = std::min(*leaves_qty, order_qty);
-
-        *leaves_qty -= fill_qty;
-        order->quantity_ -= fill_qty;
+                            OrderId new_market_order_id, MEOrdersAtPrice *orders_at_price,
+                            Quantity *leaves_qty) noexcept -> void {
+        const auto orders = orders_at_price->orders_;
+        const auto price = orders_at_price->price_;
+        auto i = orders_at_price->head_;
+        for (; *leaves_qty && i < orders_at_price->tail_; ++i) {
+            auto &order = orders[i];
+            const auto order_qty = order.quantity_;
+            if (UNLIKELY(!order_qty))
+                continue;
+            const auto fill_qty = std::min(*leaves_qty, order_qty);
+
+            *leaves_qty -= fill_qty;
+            order.quantity_ -= fill_qty;
 
-        client_response_ = {
-            ClientResponseType::FILLED,
-            client_id, ticker_id, client_order_id, new_market_order_id,
-            side, bid_itr->price_, fill_qty, *leaves_qty
-        };
-        matching_engine_->sendClientResponse(&client_response_);
+            client_response_ = {
+                ClientResponseType::FILLED,
+                client_id, ticker_id, client_order_id, new_market_order_id,
+                side, price, fill_qty, *leaves_qty
+            };
+            matching_engine_->sendClientResponse(&client_response_);
 
-        client_response_ = {
-            ClientResponseType::FILLED,
-            order->client_id_,
-            ticker_id,
-            order->client_order_id_, order->market_order_id_,
-            order->side_, bid_itr->price_, fill_qty, order->quantity_
-        };
-        matching_engine_->sendClientResponse(&client_response_);
+            client_response_ = {
+                ClientResponseType::FILLED,
+                order.client_id_,
+                ticker_id,
+                order.client_order_id_, order.market_order_id_,
+                orders_at_price->side_, price, fill_qty, order.quantity_
+            };
+            matching_engine_->sendClientResponse(&client_response_);
 
+            market_update_ = {
+                MarketUpdateType::TRADE,
+                OrderId_INVALID, ticker_id, side, price,
+                fill_qty, Priority_INVALID
+            };
+            matching_engine_->sendMarketUpdate(&market_update_);
 
-        market_update_ = {
-            MarketUpdateType::TRADE,
-            OrderId_INVALID, ticker_id, side, bid_itr->price_,
-            fill_qty, Priority_INVALID
-        };
-        matching_engine_->sendMarketUpdate(&market_update_);
+            if (order.quantity_)
+                break;
 
-        if (!order->quantity_) {
             market_update_ = {
                 MarketUpdateType::CANCEL,
-                order->market_order_id_, ticker_id, order->side_,
-                order->price_, order_qty, Priority_INVALID
+                order.market_order_id_, ticker_id, orders_at_price->side_,
+                price, order_qty, Priority_INVALID
             };
             matching_engine_->sendMarketUpdate(&market_update_);
 
-            removeOrder(order);
+            order_pool_.deallocate(cid_oid_to_order_.erase(order.client_id_, order.client_order_id_));
+            --orders_at_price->num_orders_;
         }
+
+        orders_at_price->head_ = i;
+        trimOrders(orders_at_price);
     }
 
     auto MEOrderBook::checkForMatch(ClientId client_id, OrderId client_order_id, TickerId ticker_id, Side side,
-                                    Price price, Quantity qty, Quantity new_market_order_id) noexcept {
+                                    Price price, Quantity qty, Quantity new_market_order_id) noexcept -> Quantity {
         auto leaves_qty = qty;
         if (side == Side::BUY) {
-            while (leaves_qty && asks_by_price_) {
-                const auto ask_itr = asks_by_price_->first_me_order_;
-                if (LIKELY(price < ask_itr->price_)) { break; }
+            for (auto asks = price_ladder_.best(Side::SELL); leaves_qty && asks; asks = price_ladder_.best(Side::SELL)) {
+                if (LIKELY(price < asks->price_)) { break; }
 
-                match(ticker_id, client_id, side, client_order_id, new_market_order_id, ask_itr, &leaves_qty);
+                match(ticker_id, client_id, side, client_order_id, new_market_order_id, asks, &leaves_qty);
             }
         }
 
         if (side == Side::SELL) {
-            while (leaves_qty && bids_by_price_) {
-                const auto bid_itr = bids_by_price_->first_me_order_;
-                if (LIKELY(price > bid_itr->price_)) { break; }
+            for (auto bids = price_ladder_.best(Side::BUY); leaves_qty && bids; bids = price_ladder_.best(Side::BUY)) {
+                if (LIKELY(price > bids->price_)) { break; }
 
-                match(ticker_id, client_id, side, client_order_id, new_market_order_id, bid_itr, &leaves_qty);
+                match(ticker_id, client_id, side, client_order_id, new_market_order_id, bids, &leaves_qty);
             }
         }
         return leaves_qty;
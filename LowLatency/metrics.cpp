@@ -0,0 +1,118 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#include <fstream>
+#include <sstream>
+
+#include "metrics.h"
+#include "thread_utils.h"
+
+namespace LL::Common {
+    auto LatencyHistogram::Snapshot::percentile(double pct) const noexcept -> uint64_t {
+        if (!count_)
+            return 0;
+        const auto target = static_cast<uint64_t>(static_cast<double>(count_) * pct / 100.0 + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= std::max<uint64_t>(target, 1))
+                return std::min(bucketValue(i), max_);
+        }
+        return max_;
+    }
+
+    auto LatencyHistogram::Snapshot::toString() const -> std::string {
+        std::stringstream ss;
+        ss << "count:" << count_
+                << " mean:" << (count_ ? sum_ / count_ : 0)
+                << " p50:" << percentile(50)
+                << " p99:" << percentile(99)
+                << " p99.9:" << percentile(99.9)
+                << " max:" << max_;
+        return ss.str();
+    }
+
+    auto LatencyHistogram::snapshot(Snapshot *snapshot) const noexcept -> void {
+        snapshot->count_ = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            snapshot->counts_[i] = counts_[i].load(std::memory_order_relaxed);
+            snapshot->count_ += snapshot->counts_[i];
+        }
+        snapshot->max_ = max_.load(std::memory_order_relaxed);
+        snapshot->sum_ = sum_.load(std::memory_order_relaxed);
+    }
+
+    auto MetricsRegistry::instance() -> MetricsRegistry & {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    MetricsRegistry::~MetricsRegistry() {
+        stop();
+    }
+
+    auto MetricsRegistry::histogram(const std::string &name) -> LatencyHistogram * {
+        std::lock_guard lock(mutex_);
+        for (auto &[histogram_name, histogram]: histograms_) {
+            if (histogram_name == name)
+                return histogram.get();
+        }
+        return histograms_.emplace_back(name, std::make_unique<LatencyHistogram>()).second.get();
+    }
+
+    auto MetricsRegistry::counter(const std::string &name) -> Counter * {
+        std::lock_guard lock(mutex_);
+        for (auto &[counter_name, counter]: counters_) {
+            if (counter_name == name)
+                return counter.get();
+        }
+        return counters_.emplace_back(name, std::make_unique<Counter>()).second.get();
+    }
+
+    auto MetricsRegistry::start(const std::string &file_name, Nanos interval) -> void {
+        ASSERT(!run_, "MetricsRegistry already started.");
+        run_ = true;
+        snapshot_thread_ = createAndStartThread(-1, "Common/MetricsRegistry",
+                                                [this, file_name, interval]() { run(file_name, interval); });
+        ASSERT(snapshot_thread_ != nullptr, "Failed to start MetricsRegistry thread.");
+    }
+
+    auto MetricsRegistry::stop() -> void {
+        run_ = false;
+        if (snapshot_thread_) {
+            snapshot_thread_->join();
+            delete snapshot_thread_;
+            snapshot_thread_ = nullptr;
+        }
+    }
+
+    auto MetricsRegistry::dump(std::ostream &os) -> void {
+        std::string time_str;
+        std::lock_guard lock(mutex_);
+        os << getCurrentTimeStr(&time_str) << " metrics" << std::endl;
+        for (const auto &[name, histogram]: histograms_) {
+            histogram->snapshot(&snapshot_);
+            os << "  " << name << " " << snapshot_.toString() << std::endl;
+        }
+        for (const auto &[name, counter]: counters_)
+            os << "  " << name << " " << counter->value() << std::endl;
+    }
+
+    auto MetricsRegistry::run(std::string file_name, Nanos interval) -> void {
+        std::ofstream file(file_name);
+        ASSERT(file.is_open(), "Could not open metrics file:" + file_name);
+
+        auto next_dump = getCurrentNanos() + interval;
+        while (run_) {
+            if (getCurrentNanos() >= next_dump) {
+                dump(file);
+                file.flush();
+                next_dump += interval;
+            }
+            using namespace std::chrono_literals;
+            std::this_thread::sleep_for(10ms);
+        }
+        dump(file);
+    }
+}
@@ -0,0 +1,141 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+
+#include "sharded_matching_engine.h"
+
+namespace LL::Exchange {
+    ShardedMatchingEngine::ShardedMatchingEngine(ClientRequestLFQueue *client_requests,
+                                                 ClientResponseLFQueue *client_responses,
+                                                 MEMarketUpdateRing *market_updates, size_t num_shards,
+                                                 const InstrumentRegistry &instruments,
+                                                 const std::vector<size_t> &ticker_shards)
+        : incoming_requests_(client_requests),
+          outgoing_ogw_responses_(client_responses),
+          outgoing_md_updates_(market_updates),
+          shards_(num_shards),
+          ticker_shard_(instruments.size()),
+          logger_("exchange_sharded_matching_engine.log"),
+          requests_routed_(MetricsRegistry::instance().counter("Exchange/ShardedMatchingEngine/requests_routed")),
+          merge_batch_(MetricsRegistry::instance().histogram("Exchange/ShardedMatchingEngine/merge_batch")) {
+        ASSERT(num_shards && num_shards <= ME_MAX_SHARDS, "Invalid number of shards:" + std::to_string(num_shards));
+        ASSERT(ticker_shards.empty() || ticker_shards.size() == instruments.size(),
+               "Expected a shard for each of the " + std::to_string(instruments.size()) + " tickers.");
+
+        for (size_t i = 0; i < ticker_shard_.size(); ++i) {
+            ticker_shard_[i] = ticker_shards.empty() ? i % num_shards : ticker_shards[i];
+            ASSERT(ticker_shard_[i] < num_shards, "Ticker " + std::to_string(i) + " assigned to invalid shard:"
+                                                  + std::to_string(ticker_shard_[i]));
+        }
+
+        for (size_t i = 0; i < num_shards; ++i) {
+            auto &shard = shards_[i];
+            shard.requests_ = std::make_unique<ClientRequestLFQueue>(ME_MAX_CLIENT_UPDATES);
+            shard.responses_ = std::make_unique<ClientResponseLFQueue>(ME_MAX_CLIENT_UPDATES);
+            shard.market_updates_ = std::make_unique<MEMarketUpdateRing>(ME_MAX_MARKET_UPDATES);
+            shard.md_consumer_id_ = shard.market_updates_->addConsumer();
+            shard.engine_ = std::make_unique<MatchingEngine>(shard.requests_.get(), shard.responses_.get(),
+                                                             shard.market_updates_.get(), instruments, i);
+        }
+    }
+
+    ShardedMatchingEngine::ShardedMatchingEngine(ClientRequestMPSCQueue *client_requests,
+                                                 ClientResponseLFQueue *client_responses,
+                                                 MEMarketUpdateRing *market_updates, size_t num_shards,
+                                                 const InstrumentRegistry &instruments,
+                                                 const std::vector<size_t> &ticker_shards)
+        : ShardedMatchingEngine(static_cast<ClientRequestLFQueue *>(nullptr), client_responses, market_updates,
+                                num_shards, instruments, ticker_shards) {
+        incoming_gateway_requests_ = client_requests;
+    }
+
+    ShardedMatchingEngine::~ShardedMatchingEngine() {
+        stop();
+
+        using namespace std::literals::chrono_literals;
+        std::this_thread::sleep_for(1s);
+
+        // The engines sleep out their own threads before their books and queues go away.
+        for (auto &shard: shards_)
+            shard.engine_.reset();
+
+        incoming_requests_ = nullptr;
+        incoming_gateway_requests_ = nullptr;
+        outgoing_ogw_responses_ = nullptr;
+        outgoing_md_updates_ = nullptr;
+    }
+
+    auto ShardedMatchingEngine::start() -> void {
+        run_ = true;
+        for (auto &shard: shards_)
+            shard.engine_->start();
+        ASSERT(createAndStartThread(-1,
+                                    "Exchange/ShardedMatchingEngine",
+                                    [this]() {
+                                        run();
+                                    }) != nullptr, "Failed to start ShardedMatchingEngine::start()");
+    }
+
+    auto ShardedMatchingEngine::stop() -> void {
+        for (auto &shard: shards_)
+            shard.engine_->stop();
+        run_ = false;
+    }
+
+    auto ShardedMatchingEngine::setIdleStrategy(IdleStrategyType type) -> void {
+        for (auto &shard: shards_)
+            shard.engine_->setIdleStrategy(type);
+        idle_strategy_ = IdleStrategy(type == IdleStrategyType::PARK ? IdleStrategyType::BACKOFF : type);
+    }
+
+    auto ShardedMatchingEngine::setBatchSize(size_t batch_size) -> void {
+        for (auto &shard: shards_)
+            shard.engine_->setBatchSize(batch_size);
+    }
+
+    // Moves what fits of the shard's responses and market updates to the outgoing queues in the order the shard
+    // produced them.
+    auto ShardedMatchingEngine::mergeShard(Shard &shard) noexcept -> size_t {
+        auto &responses = *shard.responses_;
+        const auto num_responses = outgoing_ogw_responses_->reserve(responses.peek(responses.capacity()));
+        for (size_t i = 0; i < num_responses; ++i)
+            *outgoing_ogw_responses_->getWriteSlot(i) = *responses.getReadSlot(i);
+        if (num_responses) {
+            outgoing_ogw_responses_->publish(num_responses);
+            responses.consume(num_responses);
+        }
+
+        auto &updates = *shard.market_updates_;
+        const auto num_updates = outgoing_md_updates_->reserve(updates.peek(shard.md_consumer_id_,
+                                                                            updates.capacity()));
+        for (size_t i = 0; i < num_updates; ++i)
+            *outgoing_md_updates_->getWriteSlot(i) = *updates.getReadSlot(shard.md_consumer_id_, i);
+        if (num_updates) {
+            outgoing_md_updates_->publish(num_updates);
+            updates.consume(shard.md_consumer_id_, num_updates);
+        }
+
+        return num_responses + num_updates;
+    }
+
+    auto ShardedMatchingEngine::run() noexcept -> void {
+        logger_.log("%:% %() % shards:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), shards_.size());
+        while (run_) {
+            size_t work = 0;
+            if (incoming_requests_)
+                work += routeRequests(incoming_requests_);
+            if (incoming_gateway_requests_)
+                work += routeRequests(incoming_gateway_requests_);
+
+            for (auto &shard: shards_) {
+                const auto merged = mergeShard(shard);
+                if (merged)
+                    merge_batch_->record(merged);
+                work += merged;
+            }
+            idle_strategy_.idle(work);
+        }
+    }
+}
@@ -5,19 +5,22 @@
 #include "snapshot_synthesizer.h"
 
 namespace LL::Exchange {
-    SnapshotSynthesizer::SnapshotSynthesizer(MDPMarketUpdateLFQueue *market_updates, const std::string &iface,
-                                             const std::string &snapshot_ip, int snapshot_port)
+    SnapshotSynthesizer::SnapshotSynthesizer(MEMarketUpdateRing *market_updates, const std::string &iface,
+                                             const std::string &snapshot_ip, int snapshot_port,
+                                             const InstrumentRegistry &instruments)
         : snapshot_md_updates_(market_updates),
-          logger_("exchange_snapshot_synthesizer.log"), snapshot_socket_(logger_),
-          order_pool_(ME_MAX_ORDER_IDS) {
+          md_consumer_id_(market_updates->addConsumer()),
+          logger_("exchange_snapshot_synthesizer.log"),
+          snapshot_socket_(logger_, McastMaxDatagramSize, "Exchange/SnapshotSynthesizer/snapshot_socket"),
+          order_pool_(instruments.totalMaxOrders(),
+                      instruments.totalMaxOrders() * sizeof(MEMarketUpdate) >= HUGE_PAGE_SIZE) {
         ASSERT(snapshot_socket_.init(snapshot_ip, iface, snapshot_port, false) >= 0,
                "Unable to create snapshot mcast socket. error:" + std::string(std::strerror(errno)));
-        for (auto &orders: ticker_orders_)
-            orders.fill(nullptr);
     }
 
     SnapshotSynthesizer::~SnapshotSynthesizer() {
         stop();
+        snapshot_md_updates_->removeConsumer(md_consumer_id_);
     }
 
     auto SnapshotSynthesizer::start() -> void {
@@ -30,19 +33,27 @@ namespace LL::Exchange {
         run_ = false;
     }
 
-    auto SnapshotSynthesizer::addToSnapshot(const MDPMarketUpdate *market_update) {
-        const auto &me_market_update = market_update->me_market_update_;
-        auto *orders = &ticker_orders_.at(me_market_update.ticker_id_);
+    auto SnapshotSynthesizer::setIdleStrategy(IdleStrategyType type) -> void {
+        idle_strategy_ = IdleStrategy(type,
+                                      type == IdleStrategyType::PARK
+                                          ? snapshot_md_updates_->getWakeSignal()
+                                          : nullptr);
+    }
+
+    auto SnapshotSynthesizer::addToSnapshot(size_t seq_num, const MEMarketUpdate *market_update) {
+        const auto &me_market_update = *market_update;
+        const auto ticker_id = me_market_update.ticker_id_;
+        const auto order_id = me_market_update.order_id_;
         switch (me_market_update.type_) {
             case MarketUpdateType::ADD: {
-                auto order = orders->at(me_market_update.order_id_);
+                auto order = ticker_orders_.find(ticker_id, order_id);
                 ASSERT(order == nullptr, "Received:" + me_market_update.toString()
                                          + " but order already exists: " + (order ? order->toString() : ""));
-                orders->at(me_market_update.order_id_) = order_pool_.allocate(me_market_update);
+                ticker_orders_.insert(ticker_id, order_id, order_pool_.allocate(me_market_update));
             }
             break;
             case MarketUpdateType::MODIFY: {
-                auto order = orders->at(me_market_update.order_id_);
+                auto order = ticker_orders_.find(ticker_id, order_id);
                 ASSERT(order != nullptr, "Received:" + me_market_update.toString()
                                          + " but order does not exist.");
                 ASSERT(order->order_id_ == me_market_update.order_id_,
@@ -56,7 +67,7 @@ namespace LL::Exchange {
 
             break;
             case MarketUpdateType::CANCEL: {
-                auto order = orders->at(me_market_update.order_id_);
+                auto order = ticker_orders_.find(ticker_id, order_id);
                 ASSERT(order != nullptr, "Received:" + me_market_update.toString()
                                          + " but order does not exist.");
                 ASSERT(order->order_id_ == me_market_update.order_id_,
@@ -65,7 +76,7 @@ namespace LL::Exchange {
                        "Expecting existing order to match new one.");
 
                 order_pool_.deallocate(order);
-                orders->at(me_market_update.order_id_) = nullptr;
+                ticker_orders_.erase(ticker_id, order_id);
             }
             break;
 
@@ -77,14 +88,35 @@ namespace LL::Exchange {
                 break;
         }
 
-        ASSERT(market_update->seq_num_ == last_inc_seq_num_ + 1,
+        ASSERT(seq_num == last_inc_seq_num_ + 1,
                "Expected incremental seq_nums to increase.");
-        last_inc_seq_num_ = market_update->seq_num_;
+        last_inc_seq_num_ = seq_num;
     }
 
     auto SnapshotSynthesizer::publishSnapshot() {
     }
 
     auto SnapshotSynthesizer::run() -> void {
+        logger_.log("%:% %() %\n", __FILE__, __LINE__, __FUNCTION__, getCurrentTimeStr(&time_str_));
+        while (run_) {
+            const auto num_updates = snapshot_md_updates_->peek(md_consumer_id_, snapshot_md_updates_->capacity());
+            for (size_t i = 0; i < num_updates; ++i) {
+                const auto market_update = snapshot_md_updates_->getReadSlot(md_consumer_id_, i);
+                const auto seq_num = snapshot_md_updates_->getSequence(md_consumer_id_, i);
+                logger_.log("%:% %() % Processing seq:% %\n", __FILE__, __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_), seq_num, *market_update);
+
+                addToSnapshot(seq_num, market_update);
+            }
+            if (num_updates)
+                snapshot_md_updates_->consume(md_consumer_id_, num_updates);
+
+            if (getCurrentNanos() - last_snapshot_time_ > 60 * NANOS_TO_SECS) {
+                last_snapshot_time_ = getCurrentNanos();
+                publishSnapshot();
+            }
+
+            idle_strategy_.idle(num_updates);
+        }
     }
 }
@@ -5,6 +5,16 @@
 #include "tcp_server.h"
 
 namespace LL::Common {
+    TCPServer::~TCPServer() {
+        for (auto socket: connections_)
+            delete socket;
+        connections_.clear();
+        ready_sockets_.clear();
+
+        if (epoll_fd_ >= 0)
+            close(epoll_fd_);
+    }
+
     auto TCPServer::listen(const std::string &iface, int port) -> void {
         epoll_fd_ = epoll_create(1);
 
@@ -17,54 +27,91 @@ namespace LL::Common {
                std::to_string(port) + " error:" +
                std::string(std::strerror(errno)));
 
-        ASSERT(addToEpollList(&listener_socket_),
+        ASSERT(addToEpollList(&listener_socket_, EPOLLET | EPOLLIN),
                "epoll_ctl() failed. error:" +
                std::string(std::strerror(errno)));
     }
 
     auto TCPServer::poll() noexcept -> void {
-        const int max_events = 1 + send_sockets_.size() + receive_sockets_.size();
-
-        const int n = epoll_wait(epoll_fd_, events_, max_events, 0);
+        const int n = epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), 0);
         bool have_new_connection = false;
         for (int i = 0; i < n; ++i) {
             const auto &event = events_[i];
             auto socket = static_cast<TCPSocket *>(event.data.ptr);
 
+            if (socket == &listener_socket_) {
+                logger_.log("%:% %() % EPOLLIN listener_socket:%\n",
+                            __FILE__, __LINE__, __FUNCTION__,
+                            getCurrentTimeStr(&time_str_), socket->socket_fd_);
+                have_new_connection = true;
+                continue;
+            }
+
             if (event.events & EPOLLIN) {
-                if (socket == &listener_socket_) {
-                    logger_.log("%:% %() % EPOLLIN listener_socket:%\n",
-                                __FILE__, __LINE__, __FUNCTION__,
-                                getCurrentTimeStr(&time_str_), socket->socket_fd_);
-                    have_new_connection = true;
-                    continue;
-                }
                 logger_.log("%:% %() % EPOLLIN socket:%\n",
                             __FILE__, __LINE__, __FUNCTION__,
                             getCurrentTimeStr(&time_str_), socket->socket_fd_);
-                if (std::find(receive_sockets_.begin(), receive_sockets_.end(), socket) ==
-                    receive_sockets_.end())
-                    receive_sockets_.push_back(socket);
+                socket->recv_ready_ = true;
             }
             if (event.events & EPOLLOUT) {
                 logger_.log("%:% %() % EPOLLOUT socket:%\n",
                             __FILE__, __LINE__, __FUNCTION__,
                             getCurrentTimeStr(&time_str_), socket->socket_fd_);
-                if (std::find(send_sockets_.begin(), send_sockets_.end(), socket) ==
-                    send_sockets_.end())
-                    send_sockets_.push_back(socket);
+                socket->send_blocked_ = false;
             }
-            if (event.events & (EPOLLERR | EPOLLHUP)) {
+            if (event.events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
                 logger_.log("%:% %() % EPOLLERR socket:%\n",
                             __FILE__, __LINE__, __FUNCTION__,
                             getCurrentTimeStr(&time_str_), socket->socket_fd_);
-                if (std::find(receive_sockets_.begin(), receive_sockets_.end(), socket) !=
-                    receive_sockets_.end())
-                    receive_sockets_.push_back(socket);
+                // Drain whatever the peer sent before hanging up, the read that returns 0 marks the socket closed.
+                socket->recv_ready_ = true;
+                if (event.events & EPOLLERR)
+                    socket->closed_ = true;
+            }
+            if (socket->needsService())
+                socket->markReady();
+        }
+
+        if (have_new_connection)
+            acceptConnections();
+    }
+
+    auto TCPServer::sendAndRecv() noexcept -> void {
+        START_MEASURE(Common_TCPServer_sendAndRecv);
+        auto recv = false;
+
+        // Indexed loop, callbacks may append sockets they sent on to ready_sockets_.
+        for (size_t i = 0; i < ready_sockets_.size(); ++i) {
+            auto socket = ready_sockets_[i];
+            if (socket->recv_ready_ && !socket->closed_)
+                recv |= socket->recv();
+        }
+
+        if (recv)
+            recv_finished_callback_();
+
+        size_t num_ready = 0;
+        for (size_t i = 0; i < ready_sockets_.size(); ++i) {
+            auto socket = ready_sockets_[i];
+            if (socket->hasPendingSend() && !socket->send_blocked_ && !socket->closed_)
+                socket->flushSend();
+
+            if (socket->closed_) {
+                closeConnection(socket);
+            } else if (socket->needsService()) {
+                ready_sockets_[num_ready++] = socket;
+            } else {
+                socket->in_ready_list_ = false;
             }
         }
+        ready_sockets_.resize(num_ready);
+
+        if (recv)
+            RECORD_MEASURE(Common_TCPServer_sendAndRecv, send_and_recv_latency_);
+    }
 
-        while (have_new_connection) {
+    auto TCPServer::acceptConnections() noexcept -> void {
+        while (true) {
             logger_.log("%:% %() % have_new_connection\n",
                         __FILE__, __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_));
@@ -74,8 +121,8 @@ namespace LL::Common {
             if (fd == -1)
                 break;
 
-            ASSERT(setNonBlocking(fd) && disableNagle(fd),
-                   "setNonBlocking() or  disableNagle() failed. error:" +
+            ASSERT(setNonBlocking(fd) && disableNagle(fd) && setSOTimestamp(fd),
+                   "setNonBlocking(), disableNagle() or setSOTimestamp() failed. error:" +
                    std::to_string(fd));
 
 
@@ -83,37 +130,40 @@ namespace LL::Common {
                         __FILE__, __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_), fd);
 
-            auto socket = new TCPSocket(logger_);
+            auto socket = new TCPSocket(logger_, socket_buffer_size_, metrics_prefix_ + "/TCPSocket");
             socket->socket_fd_ = fd;
             socket->recv_callback_ = recv_callback_;
-            ASSERT(addToEpollList(socket),
+            socket->ready_list_ = &ready_sockets_;
+            ASSERT(addToEpollList(socket, EPOLLET | EPOLLIN | EPOLLOUT | EPOLLRDHUP),
                    "unable to add socket error:" +
                    std::string(std::strerror(errno)));
 
-            if (std::find(receive_sockets_.begin(), receive_sockets_.end(), socket) ==
-                receive_sockets_.end())
-                receive_sockets_.push_back(socket);
+            if (static_cast<size_t>(fd) >= connections_.size())
+                connections_.resize(std::max<size_t>(fd + 1, connections_.size() * 2), nullptr);
+            connections_[fd] = socket;
+            ++num_connections_;
+
+            // Data may have arrived before the socket was registered, service it once regardless of the first edge.
+            socket->markReady();
         }
     }
 
-    auto TCPServer::sendAndRecv() noexcept -> void {
-        auto recv = false;
+    auto TCPServer::closeConnection(TCPSocket *socket) noexcept -> void {
+        logger_.log("%:% %() % closing socket:% pending_send:%\n",
+                    __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), socket->socket_fd_, socket->outbound_data_.size());
 
-        std::for_each(receive_sockets_.begin(), receive_sockets_.end(), [&](TCPSocket *socket) {
-            recv |= socket->sendAndRecv();
-        });
+        if (disconnect_callback_)
+            disconnect_callback_(socket);
 
-        if (recv)
-            recv_finished_callback_();
-
-        std::for_each(send_sockets_.begin(), send_sockets_.end(), [&](TCPSocket *socket) {
-            socket->sendAndRecv();
-        });
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket->socket_fd_, nullptr);
+        connections_[socket->socket_fd_] = nullptr;
+        --num_connections_;
+        delete socket;
     }
 
-    auto TCPServer::addToEpollList(TCPSocket *socket) {
-        // epoll_event ev{EPOLLET | EPOLLIN, {reinterpret_cast<void *>(socket)}};
-        epoll_event ev{static_cast<uint32_t>(EPOLLET | EPOLLIN), {reinterpret_cast<void *>(socket)}};
+    auto TCPServer::addToEpollList(TCPSocket *socket, uint32_t events) -> bool {
+        epoll_event ev{events, {reinterpret_cast<void *>(socket)}};
         return !epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket->socket_fd_, &ev);
-    };
+    }
 }
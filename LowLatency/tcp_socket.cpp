@@ -17,57 +17,86 @@ namespace LL::Common {
     }
 
     auto TCPSocket::sendAndRecv() noexcept -> bool {
-        char ctrl[CMSG_SPACE(sizeof(struct timeval))];
-        auto cmsg = reinterpret_cast<struct cmsghdr *>(ctrl);
+        const auto recvd = recv();
+        flushSend();
+        return recvd;
+    }
 
-        iovec iov{
-            inbound_data_.data() + next_recv_valid_index_,
-            TCPBufferSize - next_recv_valid_index_
-        };
-        msghdr msg{
-            &socket_attrib_,
-            sizeof(socket_attrib_), &iov, 1, ctrl, sizeof(ctrl), 0
-        };
+    auto TCPSocket::recv() noexcept -> bool {
+        char ctrl[TimestampCtrlSize];
+        msghdr msg{};
 
-        const auto read_size = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
-        if (read_size > 0) {
-            next_recv_valid_index_ += read_size;
+        // A full inbound buffer means the callback is behind, leave the data in the kernel until it catches up.
+        ssize_t read_size = 0;
+        if (LIKELY(inbound_data_.freeSpace())) {
+            const auto free_space = inbound_data_.freeSpace();
+            iovec iov{inbound_data_.reserve(free_space), free_space};
+            msg = {
+                &socket_attrib_,
+                sizeof(socket_attrib_), &iov, 1, ctrl, sizeof(ctrl), 0
+            };
+            read_size = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
 
-            Nanos kernel_time{0};
-            timeval time_kernel;
-            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS
-                && cmsg->cmsg_len == CMSG_LEN(sizeof(time_kernel))) {
-                memcpy(&time_kernel, CMSG_DATA(cmsg), sizeof(time_kernel));
-                kernel_time = time_kernel.tv_sec * NANOS_TO_SECS + time_kernel.tv_usec * NANOS_TO_MICROS;
-            }
+            // A short read drained the kernel buffer, the next data arrives with a fresh EPOLLIN edge.
+            if (read_size < static_cast<ssize_t>(free_space))
+                recv_ready_ = false;
+            if (read_size == 0 || (read_size < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+                closed_ = true;
+        }
+        if (read_size > 0) {
+            START_MEASURE(Common_TCPSocket_read);
+            TTT_MEASURE(T1_OrderServer_TCP_read, logger_);
+            inbound_data_.commit(read_size);
 
+            const auto kernel_time = getKernelTimestamp(&msg);
             const auto user_time = getCurrentNanos();
+            if (LIKELY(kernel_time && user_time >= kernel_time))
+                kernel_to_user_latency_->record(user_time - kernel_time);
 
             logger_.log("%:% %() % read socket:% len:% utime:% ktime:% diff:%\n",
                         __FILE__, __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_),
-                        socket_fd_, next_recv_valid_index_,
+                        socket_fd_, inbound_data_.size(),
                         user_time,
                         kernel_time,
                         (user_time - kernel_time));
-            recv_callback_(this, kernel_time);
+            recv_callback_(this, kernel_time ? kernel_time : user_time);
+            RECORD_MEASURE(Common_TCPSocket_read, read_to_callback_latency_);
         }
 
-        if (next_send_valid_index_ > 0) {
-            const auto n = ::send(socket_fd_, outbound_data_.data(), next_send_valid_index_,
+        return read_size > 0;
+    }
+
+    auto TCPSocket::flushSend() noexcept -> void {
+        // Whatever the kernel did not take stays queued and goes out first on the next call.
+        if (!outbound_data_.empty()) {
+            const auto n = ::send(socket_fd_, outbound_data_.data(), outbound_data_.size(),
                                   MSG_DONTWAIT | MSG_NOSIGNAL);
-            logger_.log("%:% %() % send socket:% len:% \n",
+            if (n > 0)
+                outbound_data_.consume(n);
+            if (!outbound_data_.empty()) {
+                if (n >= 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+                    send_blocked_ = true;
+                else
+                    closed_ = true;
+            }
+            TTT_MEASURE(T6t_OrderServer_TCP_write, logger_);
+            logger_.log("%:% %() % send socket:% len:% pending:%\n",
                         __FILE__, __LINE__, __FUNCTION__,
                         getCurrentTimeStr(&time_str_),
-                        socket_fd_, n);
+                        socket_fd_, n, outbound_data_.size());
         }
-        next_send_valid_index_ = 0;
-
-        return read_size > 0;
     }
 
-    auto TCPSocket::send(const void *data, size_t len) noexcept -> void {
-        memcpy(outbound_data_.data() + next_send_valid_index_, data, len);
-        next_send_valid_index_ += len;
+    auto TCPSocket::send(const void *data, size_t len) noexcept -> bool {
+        if (UNLIKELY(!outbound_data_.append(data, len))) {
+            logger_.log("%:% %() % send buffer full socket:% len:% pending:%\n",
+                        __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_),
+                        socket_fd_, len, outbound_data_.size());
+            return false;
+        }
+        markReady();
+        return true;
     }
 }
@@ -0,0 +1,254 @@
+//
+// Created by jewoo on 2026-10-17.
+//
+#include "xdp_socket.h"
+
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace LL::Common {
+    namespace {
+        constexpr size_t EthHeaderSize = 14;
+        constexpr size_t IpHeaderSize = 20;
+        constexpr size_t UdpHeaderSize = 8;
+
+        auto bpf(int cmd, bpf_attr *attr) noexcept {
+            return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+        }
+
+        constexpr auto insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) noexcept {
+            bpf_insn insn{};
+            insn.code = code;
+            insn.dst_reg = dst;
+            insn.src_reg = src;
+            insn.off = off;
+            insn.imm = imm;
+            return insn;
+        }
+
+        constexpr auto loadMem(uint8_t size, uint8_t dst, uint8_t src, int16_t off) noexcept {
+            return insn(BPF_LDX | size | BPF_MEM, dst, src, off, 0);
+        }
+
+        // 32 bit compare, jumps to the end of the program (XDP_PASS) when the field does not match.
+        constexpr auto passIfNotEqual(uint8_t reg, int32_t imm, int16_t off) noexcept {
+            return insn(BPF_JMP32 | BPF_JNE | BPF_K, reg, 0, off, imm);
+        }
+    }
+
+    XdpSocket::~XdpSocket() {
+        if (link_fd_ >= 0)
+            close(link_fd_);
+        if (prog_fd_ >= 0)
+            close(prog_fd_);
+        if (map_fd_ >= 0)
+            close(map_fd_);
+        for (auto ring: {&rx_, &fill_, &completion_}) {
+            if (ring->map_)
+                munmap(ring->map_, ring->map_size_);
+        }
+        if (xsk_fd_ >= 0)
+            close(xsk_fd_);
+        if (umem_)
+            munmap(umem_, umem_size_);
+    }
+
+    auto XdpSocket::init(const std::string &iface, int queue_id, const std::string &ip, int port) -> bool {
+        const auto ifindex = static_cast<int>(if_nametoindex(iface.c_str()));
+        if (!ifindex) {
+            logger_.log("%:% %() % unknown iface:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), iface);
+            return false;
+        }
+
+        xsk_fd_ = socket(AF_XDP, SOCK_RAW, 0);
+        if (xsk_fd_ < 0 || !createUmem() || !bindSocket(ifindex, queue_id) ||
+            !loadProgram(ifindex, inet_addr(ip.c_str()), htons(static_cast<uint16_t>(port)))) {
+            logger_.log("%:% %() % AF_XDP setup failed iface:% queue:% error:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), iface, queue_id, std::string(strerror(errno)));
+            return false;
+        }
+
+        bpf_attr attr{};
+        uint32_t key = queue_id;
+        attr.map_fd = map_fd_;
+        attr.key = reinterpret_cast<uint64_t>(&key);
+        attr.value = reinterpret_cast<uint64_t>(&xsk_fd_);
+        if (bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+            logger_.log("%:% %() % xskmap update failed error:%\n", __FILE__, __LINE__, __FUNCTION__,
+                        getCurrentTimeStr(&time_str_), std::string(strerror(errno)));
+            return false;
+        }
+
+        logger_.log("%:% %() % AF_XDP iface:% queue:% flow:%:% zero_copy:%\n", __FILE__, __LINE__, __FUNCTION__,
+                    getCurrentTimeStr(&time_str_), iface, queue_id, ip, port, zero_copy_);
+        return true;
+    }
+
+    auto XdpSocket::createUmem() -> bool {
+        umem_size_ = static_cast<size_t>(num_frames_) * XdpFrameSize;
+        auto umem = mmap(nullptr, umem_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1,
+                         0);
+        if (umem == MAP_FAILED)
+            return false;
+        umem_ = static_cast<char *>(umem);
+
+        xdp_umem_reg umem_reg{};
+        umem_reg.addr = reinterpret_cast<uint64_t>(umem_);
+        umem_reg.len = umem_size_;
+        umem_reg.chunk_size = XdpFrameSize;
+        if (setsockopt(xsk_fd_, SOL_XDP, XDP_UMEM_REG, &umem_reg, sizeof(umem_reg)) < 0)
+            return false;
+
+        // The fill ring holds every frame, the completion ring is only required by the kernel, we never transmit.
+        const uint32_t ring_size = num_frames_;
+        if (setsockopt(xsk_fd_, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) < 0 ||
+            setsockopt(xsk_fd_, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) < 0 ||
+            setsockopt(xsk_fd_, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) < 0)
+            return false;
+
+        xdp_mmap_offsets offsets{};
+        socklen_t offsets_len = sizeof(offsets);
+        if (getsockopt(xsk_fd_, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &offsets_len) < 0)
+            return false;
+
+        if (!mapRing(&fill_, offsets.fr, ring_size, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) ||
+            !mapRing(&completion_, offsets.cr, ring_size, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) ||
+            !mapRing(&rx_, offsets.rx, ring_size, sizeof(xdp_desc), XDP_PGOFF_RX_RING))
+            return false;
+
+        auto fill_addrs = static_cast<uint64_t *>(fill_.descs_);
+        for (uint32_t i = 0; i < num_frames_; ++i)
+            fill_addrs[i] = static_cast<uint64_t>(i) * XdpFrameSize;
+        fill_prod_ = num_frames_;
+        std::atomic_ref<uint32_t>(*fill_.producer_).store(fill_prod_, std::memory_order_release);
+        return true;
+    }
+
+    auto XdpSocket::mapRing(XdpRing *ring, const xdp_ring_offset &offsets, uint32_t size, size_t desc_size,
+                            off_t pgoff) -> bool {
+        ring->map_size_ = offsets.desc + size * desc_size;
+        auto map = mmap(nullptr, ring->map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, xsk_fd_, pgoff);
+        if (map == MAP_FAILED) {
+            ring->map_ = nullptr;
+            return false;
+        }
+        ring->map_ = map;
+        auto base = static_cast<char *>(map);
+        ring->producer_ = reinterpret_cast<uint32_t *>(base + offsets.producer);
+        ring->consumer_ = reinterpret_cast<uint32_t *>(base + offsets.consumer);
+        ring->flags_ = reinterpret_cast<uint32_t *>(base + offsets.flags);
+        ring->descs_ = base + offsets.desc;
+        ring->mask_ = size - 1;
+        return true;
+    }
+
+    auto XdpSocket::bindSocket(int ifindex, int queue_id) -> bool {
+        sockaddr_xdp addr{};
+        addr.sxdp_family = AF_XDP;
+        addr.sxdp_ifindex = ifindex;
+        addr.sxdp_queue_id = queue_id;
+        addr.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+        if (bind(xsk_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) {
+            zero_copy_ = true;
+            return true;
+        }
+
+        addr.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+        return bind(xsk_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+    }
+
+    // Redirects IPv4 UDP datagrams (without IP options) for ip:port to the socket of the receiving queue and passes
+    // everything else, ip and port are in network byte order.
+    auto XdpSocket::loadProgram(int ifindex, uint32_t ip, uint16_t port) -> bool {
+        bpf_attr attr{};
+        attr.map_type = BPF_MAP_TYPE_XSKMAP;
+        attr.key_size = sizeof(uint32_t);
+        attr.value_size = sizeof(int);
+        attr.max_entries = 64;
+        map_fd_ = bpf(BPF_MAP_CREATE, &attr);
+        if (map_fd_ < 0)
+            return false;
+
+        constexpr auto min_len = static_cast<int32_t>(EthHeaderSize + IpHeaderSize + UdpHeaderSize);
+        const std::vector<bpf_insn> prog = {
+            insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),
+            loadMem(BPF_W, BPF_REG_2, BPF_REG_1, offsetof(xdp_md, data)),
+            loadMem(BPF_W, BPF_REG_3, BPF_REG_1, offsetof(xdp_md, data_end)),
+            insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+            insn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, min_len),
+            insn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 16, 0),
+            loadMem(BPF_H, BPF_REG_5, BPF_REG_2, 12),
+            passIfNotEqual(BPF_REG_5, htons(0x0800), 14),
+            loadMem(BPF_B, BPF_REG_5, BPF_REG_2, EthHeaderSize),
+            passIfNotEqual(BPF_REG_5, 0x45, 12),
+            loadMem(BPF_B, BPF_REG_5, BPF_REG_2, EthHeaderSize + 9),
+            passIfNotEqual(BPF_REG_5, IPPROTO_UDP, 10),
+            loadMem(BPF_W, BPF_REG_5, BPF_REG_2, EthHeaderSize + 16),
+            passIfNotEqual(BPF_REG_5, static_cast<int32_t>(ip), 8),
+            loadMem(BPF_H, BPF_REG_5, BPF_REG_2, EthHeaderSize + IpHeaderSize + 2),
+            passIfNotEqual(BPF_REG_5, port, 6),
+            loadMem(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(xdp_md, rx_queue_index)),
+            insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd_),
+            insn(0, 0, 0, 0, 0),
+            insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),
+            insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+            insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+            insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS),
+            insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+        };
+
+        static constexpr char license[] = "GPL";
+        attr = {};
+        attr.prog_type = BPF_PROG_TYPE_XDP;
+        attr.insns = reinterpret_cast<uint64_t>(prog.data());
+        attr.insn_cnt = static_cast<uint32_t>(prog.size());
+        attr.license = reinterpret_cast<uint64_t>(license);
+        prog_fd_ = bpf(BPF_PROG_LOAD, &attr);
+        if (prog_fd_ < 0)
+            return false;
+
+        // Native mode where the driver supports it, generic mode otherwise.
+        for (const auto flags: {XDP_FLAGS_DRV_MODE, XDP_FLAGS_SKB_MODE}) {
+            attr = {};
+            attr.link_create.prog_fd = prog_fd_;
+            attr.link_create.target_ifindex = ifindex;
+            attr.link_create.attach_type = BPF_XDP;
+            attr.link_create.flags = flags;
+            link_fd_ = bpf(BPF_LINK_CREATE, &attr);
+            if (link_fd_ >= 0)
+                return true;
+        }
+        return false;
+    }
+
+    auto XdpSocket::udpPayload(const char *frame, size_t len, const char **payload, size_t *payload_len) noexcept
+        -> bool {
+        constexpr auto headers_len = EthHeaderSize + IpHeaderSize + UdpHeaderSize;
+        if (UNLIKELY(len < headers_len))
+            return false;
+        uint16_t udp_len;
+        memcpy(&udp_len, frame + EthHeaderSize + IpHeaderSize + 4, sizeof(udp_len));
+        udp_len = ntohs(udp_len);
+        if (UNLIKELY(udp_len < UdpHeaderSize || headers_len - UdpHeaderSize + udp_len > len))
+            return false;
+        *payload = frame + headers_len;
+        *payload_len = udp_len - UdpHeaderSize;
+        return true;
+    }
+
+    // With XDP_USE_NEED_WAKEUP the kernel only pulls from the fill ring after a syscall once it flags that it needs
+    // one, which is what keeps copy mode moving.
+    auto XdpSocket::wakeupIfNeeded() noexcept -> void {
+        if (std::atomic_ref<uint32_t>(*fill_.flags_).load(std::memory_order_relaxed) & XDP_RING_NEED_WAKEUP)
+            recvfrom(xsk_fd_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+}